@@ -0,0 +1,130 @@
+// Renders random_scene() (a procedural sphere field with --spheres, the emissive variant with
+// --lights) without a window or GL context and writes the result to disk; the format follows the
+// output extension (.ppm, .png, .pfm).
+#include <iostream>
+#include <chrono>
+#include <string>
+#include "glm/glm.hpp"
+#include "hittable.h"
+#include "bvh.h"
+#include "wide_bvh.h"
+#include "sphere_set.h"
+#include "camera.h"
+#include "scene.h"
+#include "light.h"
+#include "renderer.h"
+#include "image_io.h"
+
+using namespace std;
+
+static void print_usage(const char* name)
+{
+    std::cout << "usage: " << name << " [--width w] [--height h] [--spp samples] [--depth max_depth] [--rr-depth min_depth]"
+        << " [--min-spp samples] [--max-error relative_error] [--sample-map counts.png|ppm|pfm]"
+        << " [--threads count] [--bvh binary|bvh4|bvh8] [--soa] [--spheres count] [--lights] [--no-nee]"
+        << " [--sampler independent|stratified|sobol|bluenoise] [--output image.png|ppm|pfm]" << std::endl;
+}
+
+int main(int argc, char** argv) {
+
+    render_settings settings;
+    bvh_layout layout = bvh_layout::binary;
+    int sphereCount = 0;
+    int threads = 0;
+    bool soa = false;
+    bool emitters = false;
+    string output = "image.png";
+    string sampleMap;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--width" && hasValue) settings.width = std::stoi(argv[++i]);
+        else if (arg == "--height" && hasValue) settings.height = std::stoi(argv[++i]);
+        else if (arg == "--spp" && hasValue) settings.samples = std::stoi(argv[++i]);
+        else if (arg == "--depth" && hasValue) settings.maxDepth = std::stoi(argv[++i]);
+        else if (arg == "--rr-depth" && hasValue) settings.rrMinDepth = std::stoi(argv[++i]);
+        else if (arg == "--min-spp" && hasValue) settings.minSamples = std::stoi(argv[++i]);
+        else if (arg == "--max-error" && hasValue) settings.maxRelError = std::stof(argv[++i]);
+        else if (arg == "--sample-map" && hasValue) sampleMap = argv[++i];
+        else if (arg == "--threads" && hasValue) threads = std::stoi(argv[++i]);
+        else if (arg == "--spheres" && hasValue) sphereCount = std::stoi(argv[++i]);
+        else if (arg == "--soa") soa = true;
+        else if (arg == "--lights") emitters = true;
+        else if (arg == "--no-nee") settings.sampleLights = false;
+        else if (arg == "--output" && hasValue) output = argv[++i];
+        else if (arg == "--sampler" && hasValue) {
+            if (!rtweekend::parse_sampler_type(argv[++i], settings.samplerType)) {
+                std::cout << "unknown sampler " << argv[i] << ", expected independent, stratified, sobol or bluenoise" << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--bvh" && hasValue) {
+            if (!parse_bvh_layout(argv[++i], layout)) {
+                std::cout << "unknown bvh layout " << argv[i] << ", expected binary, bvh4 or bvh8" << std::endl;
+                return 1;
+            }
+        }
+        else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (settings.width < 2 || settings.height < 2 || settings.samples < 1 || settings.maxDepth < 1) {
+        std::cout << "resolution must be at least 2x2, spp and depth at least 1" << std::endl;
+        return 1;
+    }
+    if (threads < 0) {
+        std::cout << "thread count must not be negative (0 picks the hardware concurrency)" << std::endl;
+        return 1;
+    }
+    settings.threads = static_cast<unsigned>(threads);
+
+    auto buildStart = std::chrono::steady_clock::now();
+    hittable_list scene = sphereCount > 0 ? procedural_scene(sphereCount) : emitters ? random_scene_lights() : random_scene();
+    light_list lights(scene);
+    shared_ptr<hittable> world = soa ? make_sphere_accelerator(scene, layout) : make_accelerator(scene, layout);
+    std::chrono::duration<double> buildTime = std::chrono::steady_clock::now() - buildStart;
+
+    const float aspect_ratio = static_cast<float>(settings.width) / settings.height;
+    blurcamera cam = random_scene_camera(aspect_ratio);
+    if (emitters)
+        settings.skyIntensity = 0.05f;
+    renderer tracer(settings);
+    tracer.setLights(&lights);
+    vector<glm::vec3> image;
+
+    std::cout << "rendering " << settings.width << "x" << settings.height << " at " << settings.samples
+        << " spp with " << tracer.thread_count() << " threads" << std::endl;
+    auto renderStart = std::chrono::steady_clock::now();
+    tracer.render(*world, cam, image);
+    std::chrono::duration<double> renderTime = std::chrono::steady_clock::now() - renderStart;
+
+    traversal_stats stats = tracer.getStats();
+    path_stats paths = tracer.getPathStats();
+    std::cout << "scene built in " << buildTime.count() << "s, rendered in " << renderTime.count() << "s, "
+        << stats.rays / renderTime.count() / 1e6 << " Mrays/s, "
+        << stats.nodes_per_ray() << " nodes visited per ray, "
+        << paths.average_length() << " segments per path, "
+        << static_cast<double>(paths.shadowRays) / paths.paths << " shadow rays per path, "
+        << static_cast<double>(paths.paths) / image.size() << " samples per pixel" << std::endl;
+
+    if (!image_io::write_image(output, settings.width, settings.height, image)) {
+        std::cout << "failed to write " << output << std::endl;
+        return 1;
+    }
+    std::cout << "wrote " << output << std::endl;
+
+    if (!sampleMap.empty()) {
+        // samples per pixel scaled so the --spp budget maps to white
+        const auto& counts = tracer.getSampleCounts();
+        vector<glm::vec3> countImage(counts.size());
+        for (size_t p = 0; p < counts.size(); ++p)
+            countImage[p] = glm::vec3(static_cast<float>(counts[p]) / settings.samples);
+        if (!image_io::write_image(sampleMap, settings.width, settings.height, countImage)) {
+            std::cout << "failed to write " << sampleMap << std::endl;
+            return 1;
+        }
+        std::cout << "wrote " << sampleMap << std::endl;
+    }
+    return 0;
+}
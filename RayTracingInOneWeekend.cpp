@@ -1,21 +1,29 @@
 ﻿#include <iostream>
-#include <limits>
-#include <functional>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include "glad/glad.h"
 #include "GLFW/glfw3.h"
 #include "glm/glm.hpp"
 #include "rtweekend.h"
 #include "ray.h"
 #include "hittable.h"
+#include "bvh.h"
+#include "wide_bvh.h"
 #include "camera.h"
 #include "material.h"
+#include "scene.h"
+#include "renderer.h"
+#include "image_io.h"
 
 using namespace std;
 
 // configs
 const int window_width = 1920;
 const int window_height = 1080;
-const double infinity = std::numeric_limits<double>::infinity();
 const int samples = 500;
 const int ray_depth = 50;
 
@@ -46,55 +54,34 @@ const char* fragmentShaderSource =
 "    FragColor = texture(texture1, TexCoord);\n"
 "}\n";
 
-hittable_list random_scene() {
-    hittable_list world;
-
-    auto ground_material = make_shared<lambertian>(vec3(0.5, 0.5, 0.5));
-    world.add(make_shared<sphere>(vec3(0, -1000, 0), 1000, ground_material));
-
-    for (int a = -11; a < 11; a++) {
-        for (int b = -11; b < 11; b++) {
-            auto choose_mat = rtweekend::random_double();
-            vec3 center(a + 0.9 * rtweekend::random_double(), 0.2, b + 0.9 * rtweekend::random_double());
-
-            if ((center - vec3(4, 0.2, 0)).length() > 0.9) {
-                shared_ptr<material> sphere_material;
-
-                if (choose_mat < 0.8) {
-                    // diffuse
-                    auto albedo = vec3(rtweekend::random_double(), rtweekend::random_double(), rtweekend::random_double());
-                    sphere_material = make_shared<lambertian>(albedo);
-                    world.add(make_shared<sphere>(center, 0.2, sphere_material));
-                }
-                else if (choose_mat < 0.95) {
-                    // metal
-                    auto albedo = vec3(rtweekend::random_double(0.5, 1.0), rtweekend::random_double(0.5, 1.0), rtweekend::random_double(0.5, 1.0));
-                    auto fuzz = rtweekend::random_double(0, 0.5);
-                    sphere_material = make_shared<FuzzyMetal>(albedo, fuzz);
-                    world.add(make_shared<sphere>(center, 0.2, sphere_material));
-                }
-                else {
-                    // glass
-                    sphere_material = make_shared<dielectric>(1.5);
-                    world.add(make_shared<sphere>(center, 0.2, sphere_material));
-                }
+int main(int argc, char** argv) {
+
+    bvh_layout layout = bvh_layout::binary;
+    int sphereCount = 0;
+    int threadCount = 0;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--bvh" && i + 1 < argc) {
+            if (!parse_bvh_layout(argv[++i], layout)) {
+                std::cout << "unknown bvh layout " << argv[i] << ", expected binary, bvh4 or bvh8" << std::endl;
+                return 1;
             }
         }
+        else if (arg == "--spheres" && i + 1 < argc) {
+            sphereCount = std::stoi(argv[++i]);
+        }
+        else if (arg == "--threads" && i + 1 < argc) {
+            threadCount = std::stoi(argv[++i]);
+        }
+        else {
+            std::cout << "usage: " << argv[0] << " [--bvh binary|bvh4|bvh8] [--spheres count] [--threads count]" << std::endl;
+            return 1;
+        }
+    }
+    if (threadCount < 0) {
+        std::cout << "thread count must not be negative (0 picks the hardware concurrency)" << std::endl;
+        return 1;
     }
-
-    auto material1 = make_shared<dielectric>(1.5);
-    world.add(make_shared<sphere>(vec3(0, 1, 0), 1.0, material1));
-
-    auto material2 = make_shared<lambertian>(vec3(0.4, 0.2, 0.1));
-    world.add(make_shared<sphere>(vec3(-4, 1, 0), 1.0, material2));
-
-    auto material3 = make_shared<metal>(vec3(0.7, 0.6, 0.5));
-    world.add(make_shared<sphere>(vec3(4, 1, 0), 1.0, material3));
-
-    return world;
-}
-
-int main() {
 
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
@@ -178,86 +165,164 @@ int main() {
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-    auto* data = new unsigned char[window_height * window_width * 3];
+    // immutable storage, allocated once; the frame only ever updates it with glTexSubImage2D
+    const size_t frameBytes = static_cast<size_t>(window_width) * window_height * 3;
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGB8, window_width, window_height);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    {
+        vector<unsigned char> black(frameBytes, 0);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, window_width, window_height, GL_RGB, GL_UNSIGNED_BYTE, black.data());
+    }
 
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, window_width, window_height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
+    // two streaming unpack buffers, alternated per frame so the upload being filled is never
+    // the one the driver may still be reading from
+    unsigned int uploadPBO[2];
+    glGenBuffers(2, uploadPBO);
+    for (unsigned int pbo : uploadPBO) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, frameBytes, nullptr, GL_STREAM_DRAW);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
 
     glDisable(GL_DEPTH_TEST);
 
-    // helper functions
-    auto setPixelColor = [](int h, int w, unsigned char* p, const glm::vec3& col)
-    {
-        int index = 3 * (h * window_width + w);
-        unsigned char r = sqrt(col.r) * 255;
-        unsigned char g = sqrt(col.g) * 255;
-        unsigned char b = sqrt(col.b) * 255;
-        p[index++] = r;
-        p[index++] = g;
-        p[index++] = b;
-    };
-
 	// shapes
-    hittable_list world = random_scene();
+    shared_ptr<hittable> world = make_accelerator(sphereCount > 0 ? procedural_scene(sphereCount) : random_scene(), layout);
 	
     // rendering
-    bool needUpdate = true;
-    std::function<glm::vec3(const ray&, const hittable_list&, int)> ray_color = [&](const ray& r, const hittable_list& list, int depth)->glm::vec3
+    render_settings settings;
+    settings.width = window_width;
+    settings.height = window_height;
+    settings.samples = samples;
+    settings.maxDepth = ray_depth;
+    settings.threads = static_cast<unsigned>(threadCount);
+    renderer tracer(settings);
+
+	// camera
+    blurcamera cam = random_scene_camera(aspect_ratio);
+    std::cout << "rendering with " << tracer.thread_count() << " threads" << std::endl;
+
+    // The render thread adds one sample per pixel per pass to the accumulation buffer. Each finished
+    // tile is converted to 8 bit on its worker and marked dirty; the display loop below uploads only
+    // the dirty tiles, so workers never wait on GL.
+    std::mutex displayMutex;
+    vector<unsigned char> displayPixels(frameBytes);
+    vector<char> tileDirty(tracer.tile_count(), 0);
+    vector<size_t> dirtyTiles;
+    vector<vector<unsigned char>> tileStaging(tracer.thread_count(),
+        vector<unsigned char>(static_cast<size_t>(settings.tileSize) * settings.tileSize * 3));
+    std::atomic<bool> quit{ false };
+    accumulation_buffer accum;
+    thread_pool::task_fn publishTile = [&](size_t tile, unsigned worker)
     {
-        hit_record record;
-        if (depth <= 0) return vec3(0.f);
-    	if(list.hit(r, .001, infinity, record))
-    	{
-            ray scattered;
-            vec3 attenuation;
-            if (record.pMat->scatter(r, record, attenuation, scattered))
-            {
-                return attenuation * ray_color(scattered, list, depth - 1);
-            }
-            else
-            {
-                return vec3(0);
+        int x0, y0, x1, y1;
+        tracer.tile_bounds(tile, x0, y0, x1, y1);
+        const int rowBytes = (x1 - x0) * 3;
+        unsigned char* staging = tileStaging[worker].data();
+        unsigned char* out = staging;
+        for (int j = y0; j < y1; ++j)
+            for (int i = x0; i < x1; ++i) {
+                glm::vec3 col = accum.average(static_cast<size_t>(j) * window_width + i);
+                *out++ = image_io::encode_gamma(col.r);
+                *out++ = image_io::encode_gamma(col.g);
+                *out++ = image_io::encode_gamma(col.b);
             }
-    	}
-        glm::vec3 normDir = glm::normalize(r.direction());
-        float t = 0.5 * (normDir.y + 1);
-        return t * glm::vec3(0.5, 0.7, 1.0) + (1 - t) * glm::vec3(1);
+        std::lock_guard<std::mutex> lock(displayMutex);
+        for (int j = y0; j < y1; ++j)
+            std::copy_n(staging + (j - y0) * rowBytes, rowBytes, displayPixels.begin() + 3 * (static_cast<size_t>(j) * window_width + x0));
+        if (!tileDirty[tile]) {
+            tileDirty[tile] = 1;
+            dirtyTiles.push_back(tile);
+        }
     };
+    std::thread renderThread([&]()
+    {
+        for (int pass = 1; pass <= samples && !quit; ++pass)
+        {
+            auto passStart = std::chrono::steady_clock::now();
+            tracer.accumulate(*world, cam, accum, 1, &quit, publishTile);
+            if (quit) break;
+            std::chrono::duration<double> passTime = std::chrono::steady_clock::now() - passStart;
+            traversal_stats stats = tracer.getStats();
+            std::cout << "pass " << pass << "/" << samples << " in " << passTime.count() << "s, "
+                << stats.nodes_per_ray() << " nodes visited per ray" << std::endl;
+        }
+    });
 
-	// camera
-    glm::vec3 eye(13, 2, 3);
-    glm::vec3 center(0, 0, 0);
-    glm::vec3 up(0.f, 1.f, 0.f);
-    blurcamera cam(eye, center, up,10, 2, 2 * aspect_ratio, 0.1);
-
+    glfwSwapInterval(1);
+    unsigned int frame = 0;
+    vector<size_t> uploadTiles;
     while (!glfwWindowShouldClose(window))
     {
         glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
 
-    	if(needUpdate)
-    	{
-            for (int j = window_height - 1; j >= 0; --j) {
-                for (int i = 0; i < window_width; ++i) {
-                    float u = static_cast<float>(j) / window_height;
-                    float v = static_cast<float>(i) / window_width;
-                    glm::vec3 color(0.f);
-                	for(int s = 0; s < samples; ++s)
-                	{
-                        color += ray_color(cam.getRayFromScreenPos(u + rtweekend::random_double() / (window_height - 1), v + rtweekend::random_double() / (window_width - 1)), world, ray_depth);
-                	}
-                    color /= samples;
-                    setPixelColor(j, i, data, color);
+        // take the dirty tiles, copy them into this frame's PBO (same layout as the frame), then
+        // issue one glTexSubImage2D per tile sourced from the PBO so the transfer happens
+        // asynchronously. The mutex is only held to swap the list and for each tile copy, never across
+        // the map/unmap, so workers publishing tiles don't wait on the driver.
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, uploadPBO[frame & 1]);
+        uploadTiles.clear();
+        {
+            std::lock_guard<std::mutex> lock(displayMutex);
+            uploadTiles.swap(dirtyTiles);
+            for (size_t tile : uploadTiles)
+                tileDirty[tile] = 0;
+        }
+        auto requeue = [&]() {
+            std::lock_guard<std::mutex> lock(displayMutex);
+            for (size_t tile : uploadTiles) {
+                if (!tileDirty[tile]) {
+                    tileDirty[tile] = 1;
+                    dirtyTiles.push_back(tile);
+                }
+            }
+            uploadTiles.clear();
+        };
+        auto* mapped = uploadTiles.empty() ? nullptr : static_cast<unsigned char*>(
+            glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, frameBytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+        if (mapped) {
+            for (size_t tile : uploadTiles) {
+                int x0, y0, x1, y1;
+                tracer.tile_bounds(tile, x0, y0, x1, y1);
+                std::lock_guard<std::mutex> lock(displayMutex);
+                for (int j = y0; j < y1; ++j) {
+                    size_t offset = 3 * (static_cast<size_t>(j) * window_width + x0);
+                    std::copy_n(displayPixels.begin() + offset, (x1 - x0) * 3, mapped + offset);
                 }
             }
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, window_width, window_height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-            //needUpdate = false;
-    	}
-        
+            // GL_FALSE means the buffer contents were lost; upload these tiles again next frame
+            if (!glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER))
+                requeue();
+        }
+        else if (!uploadTiles.empty()) {
+            requeue();
+        }
+        if (!uploadTiles.empty())
+        {
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, window_width);
+            for (size_t tile : uploadTiles) {
+                int x0, y0, x1, y1;
+                tracer.tile_bounds(tile, x0, y0, x1, y1);
+                size_t offset = 3 * (static_cast<size_t>(y0) * window_width + x0);
+                glTexSubImage2D(GL_TEXTURE_2D, 0, x0, y0, x1 - x0, y1 - y0, GL_RGB, GL_UNSIGNED_BYTE,
+                    reinterpret_cast<const void*>(offset));
+            }
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+            ++frame;
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
         glUseProgram(shaderProgram);
-        glBindTexture(GL_TEXTURE_2D, texture);
     	glBindVertexArray(quadVAO);
         glDrawArrays(GL_TRIANGLES, 0, 6);
         glfwPollEvents();
         glfwSwapBuffers(window);
     }
+
+    quit = true;
+    renderThread.join();
+    glDeleteBuffers(2, uploadPBO);
+    glfwTerminate();
 }
\ No newline at end of file
@@ -0,0 +1,238 @@
+// Micro and macro benchmarks for the tracing core. Every case prints one line with its
+// throughput so runs can be diffed before and after a change.
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <type_traits>
+#include "glm/glm.hpp"
+#include "rtweekend.h"
+#include "hittable.h"
+#include "bvh.h"
+#include "wide_bvh.h"
+#include "sphere_set.h"
+#include "camera.h"
+#include "sampler.h"
+#include "scene.h"
+#include "renderer.h"
+
+using namespace std;
+
+template<typename F>
+static double seconds(F&& f)
+{
+    auto start = std::chrono::steady_clock::now();
+    f();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+// The rejection-loop samplers rtweekend.h used before the closed forms, kept as the baseline.
+template<typename Rng>
+static glm::vec3 loop_in_unit_sphere(Rng& rng)
+{
+    while (true) {
+        auto p = glm::vec3(rtweekend::random_double(rng, -1.0, 1.0), rtweekend::random_double(rng, -1.0, 1.0), rtweekend::random_double(rng, -1.0, 1.0));
+        if (length(p) >= 1) continue;
+        return p;
+    }
+}
+
+template<typename Rng>
+static glm::vec3 loop_unit_vector(Rng& rng)
+{
+    return normalize(loop_in_unit_sphere(rng));
+}
+
+template<typename Rng>
+static glm::vec3 loop_in_unit_disk(Rng& rng)
+{
+    while (true) {
+        auto p = glm::vec3(rtweekend::random_double(rng, -1, 1), rtweekend::random_double(rng, -1, 1), 0);
+        if (glm::dot(p, p) >= 1) continue;
+        return p;
+    }
+}
+
+// Generator wrapper counting its draws, to report uniforms consumed per sample. With the
+// rendering sampler every sample starts a fresh pixel sample, as on the render path.
+template<typename Gen>
+struct counting_rng
+{
+    Gen rng;
+    size_t draws = 0;
+    void start(int i) {
+        if constexpr (std::is_same_v<Gen, rtweekend::sampler>)
+            rng.start_pixel_sample(i & 1023, i >> 10, 0);
+    }
+    double next_double() { ++draws; return rng.next_double(); }
+};
+
+template<typename Gen, typename F>
+static void bench_sampler(const string& name, F&& sample)
+{
+    const int count = 10000000;
+    counting_rng<Gen> rng;
+    glm::vec3 sum(0.f);
+    double t = seconds([&] {
+        for (int i = 0; i < count; i++) {
+            rng.start(i);
+            sum += sample(rng);
+        }
+    });
+    // printing the sum keeps the loop from being optimized away
+    std::cout << "sampler " << name << ": " << count / t / 1e6 << " Msamples/s, "
+        << static_cast<double>(rng.draws) / count << " uniforms/sample (sum " << sum.x + sum.y + sum.z << ")" << std::endl;
+}
+
+template<typename Gen>
+static void bench_samplers(const string& genName)
+{
+    using rng_t = counting_rng<Gen>;
+    bench_sampler<Gen>("unit_sphere loop " + genName, [](rng_t& rng) { return loop_in_unit_sphere(rng); });
+    bench_sampler<Gen>("unit_sphere closed " + genName, [](rng_t& rng) { return rtweekend::random_in_unit_sphere(rng); });
+    bench_sampler<Gen>("unit_vector loop " + genName, [](rng_t& rng) { return loop_unit_vector(rng); });
+    bench_sampler<Gen>("unit_vector closed " + genName, [](rng_t& rng) { return rtweekend::random_unit_vector(rng); });
+    bench_sampler<Gen>("unit_disk loop " + genName, [](rng_t& rng) { return loop_in_unit_disk(rng); });
+    bench_sampler<Gen>("unit_disk closed " + genName, [](rng_t& rng) { return rtweekend::random_in_unit_disk(rng); });
+}
+
+// primary rays through the random_scene camera, reused by every traversal case
+static vector<ray> camera_rays(int width, int height)
+{
+    blurcamera cam = random_scene_camera(static_cast<float>(width) / height);
+    rtweekend::sampler rng;
+    vector<ray> rays;
+    rays.reserve(static_cast<size_t>(width) * height);
+    for (int j = 0; j < height; ++j) {
+        for (int i = 0; i < width; ++i) {
+            rng.start_pixel_sample(i, j, 0);
+            rays.push_back(cam.getRayFromScreenPos(static_cast<double>(j) / height, static_cast<double>(i) / width, rng));
+        }
+    }
+    return rays;
+}
+
+static void trace_rays(const string& name, const hittable& world, double build, const vector<ray>& rays)
+{
+    thread_traversal_stats() = traversal_stats();
+    size_t hits = 0;
+    double trace = seconds([&] {
+        hit_record rec;
+        for (const ray& r : rays)
+            hits += world.hit(r, 0.001, std::numeric_limits<double>::infinity(), rec);
+    });
+    std::cout << "traversal " << name << ": build " << build * 1e3 << " ms, "
+        << rays.size() / trace / 1e6 << " Mrays/s, " << thread_traversal_stats().nodes_per_ray()
+        << " nodes/ray, " << hits << " hits" << std::endl;
+}
+
+static void bench_traversal(const string& sceneName, const hittable_list& scene, const vector<ray>& rays)
+{
+    const char* names[] = { "binary", "bvh4", "bvh8" };
+    const bvh_layout layouts[] = { bvh_layout::binary, bvh_layout::bvh4, bvh_layout::bvh8 };
+    for (int variant = 0; variant < 6; variant++) {
+        int l = variant % 3;
+        bool soa = variant >= 3;
+        shared_ptr<hittable> world;
+        double build = seconds([&] {
+            world = soa ? make_sphere_accelerator(scene, layouts[l]) : make_accelerator(scene, layouts[l]);
+        });
+        trace_rays(sceneName + " " + names[l] + (soa ? " soa" : ""), *world, build, rays);
+    }
+}
+
+// Shadow rays from the primary hit points toward a point light above the scene. The direction is
+// the full segment to the light, so a ray is blocked by anything with t in [0.001, 0.999].
+static vector<ray> shadow_rays(const hittable& world, const vector<ray>& rays, const glm::vec3& light)
+{
+    vector<ray> shadows;
+    hit_record rec;
+    for (const ray& r : rays)
+    {
+        if (world.hit(r, 0.001, std::numeric_limits<double>::infinity(), rec))
+            shadows.push_back(ray(rec.p, light - rec.p));
+    }
+    return shadows;
+}
+
+// any-hit occluded() against closest-hit hit() on the same shadow rays
+static void bench_occlusion(const string& sceneName, const hittable_list& scene, const vector<ray>& rays)
+{
+    const char* names[] = { "binary", "bvh4", "bvh8" };
+    const bvh_layout layouts[] = { bvh_layout::binary, bvh_layout::bvh4, bvh_layout::bvh8 };
+    vector<ray> shadows = shadow_rays(*make_accelerator(scene, bvh_layout::binary), rays, glm::vec3(0, 20, 0));
+    for (int variant = 0; variant < 6; variant++) {
+        int l = variant % 3;
+        bool soa = variant >= 3;
+        shared_ptr<hittable> world = soa ? make_sphere_accelerator(scene, layouts[l]) : make_accelerator(scene, layouts[l]);
+        size_t closest = 0, any = 0;
+        thread_traversal_stats() = traversal_stats();
+        double closestTime = seconds([&] {
+            hit_record rec;
+            for (const ray& r : shadows)
+                closest += world->hit(r, 0.001, 0.999, rec);
+        });
+        double closestNodes = thread_traversal_stats().nodes_per_ray();
+        thread_traversal_stats() = traversal_stats();
+        double anyTime = seconds([&] {
+            for (const ray& r : shadows)
+                any += world->occluded(r, 0.001, 0.999);
+        });
+        std::cout << "occlusion " << sceneName << " " << names[l] << (soa ? " soa" : "") << ": closest "
+            << shadows.size() / closestTime / 1e6 << " Mrays/s " << closestNodes << " nodes/ray, any "
+            << shadows.size() / anyTime / 1e6 << " Mrays/s " << thread_traversal_stats().nodes_per_ray()
+            << " nodes/ray, " << any << " of "
+            << shadows.size() << " blocked" << (any == closest ? "" : " (MISMATCH)") << std::endl;
+    }
+}
+
+static void bench_render(const hittable_list& scene, int width, int height, int spp, unsigned threads)
+{
+    shared_ptr<hittable> world = make_accelerator(scene, bvh_layout::binary);
+    render_settings settings;
+    settings.width = width;
+    settings.height = height;
+    settings.samples = spp;
+    settings.threads = threads;
+    renderer tracer(settings);
+    blurcamera cam = random_scene_camera(static_cast<float>(width) / height);
+    vector<glm::vec3> image;
+    double t = seconds([&] { tracer.render(*world, cam, image); });
+    std::cout << "render random_scene " << width << "x" << height << " " << spp << " spp, "
+        << tracer.thread_count() << " threads: " << t << " s, "
+        << tracer.getStats().rays / t / 1e6 << " Mrays/s" << std::endl;
+}
+
+int main(int argc, char** argv) {
+
+    int spheres = 100000;
+    int threads = 0;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--spheres" && i + 1 < argc) spheres = std::stoi(argv[++i]);
+        else if (arg == "--threads" && i + 1 < argc) threads = std::stoi(argv[++i]);
+        else {
+            std::cout << "usage: " << argv[0] << " [--spheres count] [--threads count]" << std::endl;
+            return 1;
+        }
+    }
+    if (threads < 0) {
+        std::cout << "thread count must not be negative (0 picks the hardware concurrency)" << std::endl;
+        return 1;
+    }
+
+    bench_samplers<rtweekend::pcg32>("pcg32");
+    bench_samplers<rtweekend::sampler>("philox");
+    vector<ray> rays = camera_rays(640, 360);
+    // rows start at the bottom of the frame, so the first half of the rays is the ground-heavy half
+    vector<ray> bottomRays(rays.begin(), rays.begin() + rays.size() / 2);
+    bench_traversal("random_scene", random_scene(), rays);
+    bench_traversal("random_scene_bottom", random_scene(), bottomRays);
+    trace_rays("random_scene list", random_scene(), 0.0, rays);
+    bench_traversal("procedural_" + std::to_string(spheres), procedural_scene(spheres), rays);
+    bench_occlusion("random_scene", random_scene(), rays);
+    bench_occlusion("procedural_" + std::to_string(spheres), procedural_scene(spheres), rays);
+    bench_render(random_scene(), 320, 180, 16, static_cast<unsigned>(threads));
+    return 0;
+}
@@ -0,0 +1,85 @@
+#ifndef AABB_H
+#define AABB_H
+
+#include "ray.h"
+#include <limits>
+#include <utility>
+
+class aabb {
+public:
+    aabb()
+        : minimum(std::numeric_limits<float>::infinity()),
+          maximum(-std::numeric_limits<float>::infinity())
+    {}
+    aabb(const glm::vec3& a, const glm::vec3& b) : minimum(a), maximum(b) {}
+
+    glm::vec3 min() const { return minimum; }
+    glm::vec3 max() const { return maximum; }
+
+    bool empty() const { return minimum.x > maximum.x; }
+    glm::vec3 centroid() const { return 0.5f * (minimum + maximum); }
+    float surface_area() const;
+    int longest_axis() const;
+
+    void expand(const glm::vec3& p);
+    void expand(const aabb& box);
+
+    bool hit(const ray& r, double t_min, double t_max) const;
+
+private:
+    glm::vec3 minimum;
+    glm::vec3 maximum;
+};
+
+inline float aabb::surface_area() const
+{
+    if (empty()) return 0.f;
+    glm::vec3 d = maximum - minimum;
+    return 2.f * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+inline int aabb::longest_axis() const
+{
+    glm::vec3 d = maximum - minimum;
+    if (d.x > d.y && d.x > d.z) return 0;
+    return d.y > d.z ? 1 : 2;
+}
+
+inline void aabb::expand(const glm::vec3& p)
+{
+    minimum = glm::min(minimum, p);
+    maximum = glm::max(maximum, p);
+}
+
+inline void aabb::expand(const aabb& box)
+{
+    minimum = glm::min(minimum, box.minimum);
+    maximum = glm::max(maximum, box.maximum);
+}
+
+inline bool aabb::hit(const ray& r, double t_min, double t_max) const
+{
+    glm::vec3 orig = r.origin();
+    glm::vec3 dir = r.direction();
+    for (int a = 0; a < 3; a++) {
+        auto invD = 1.0f / dir[a];
+        auto t0 = (minimum[a] - orig[a]) * invD;
+        auto t1 = (maximum[a] - orig[a]) * invD;
+        if (invD < 0.0f)
+            std::swap(t0, t1);
+        t_min = t0 > t_min ? t0 : t_min;
+        t_max = t1 < t_max ? t1 : t_max;
+        if (t_max <= t_min)
+            return false;
+    }
+    return true;
+}
+
+inline aabb surrounding_box(const aabb& box0, const aabb& box1)
+{
+    aabb box = box0;
+    box.expand(box1);
+    return box;
+}
+
+#endif
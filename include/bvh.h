@@ -0,0 +1,225 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include "hittable.h"
+#include "primitive_set.h"
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+
+// Binned surface area heuristic shared by the BVH builders.
+namespace sah
+{
+    constexpr int bin_count = 12;
+    constexpr float traversal_cost = 1.0f;
+    constexpr float intersection_cost = 1.0f;
+
+    struct split {
+        int axis = -1;
+        size_t mid = 0;
+        float cost = std::numeric_limits<float>::infinity();
+    };
+
+    // Finds the cheapest binned split of order[begin, end) and partitions the range around it.
+    // Falls back to a median split on the longest centroid axis when binning cannot separate
+    // the primitives; axis stays -1 only when every centroid coincides.
+    split partition(const vector<aabb>& boxes, vector<uint32_t>& order, size_t begin, size_t end);
+}
+
+// Per-thread traversal counters, flushed once per ray so the inner loops only touch locals.
+struct traversal_stats {
+    uint64_t rays = 0;
+    uint64_t nodesVisited = 0;
+
+    double nodes_per_ray() const { return rays ? static_cast<double>(nodesVisited) / rays : 0.0; }
+};
+
+inline traversal_stats& thread_traversal_stats()
+{
+    static thread_local traversal_stats stats;
+    return stats;
+}
+
+// One node of a depth-first flattened BVH. Interior nodes keep their first child right after
+// themselves and store the offset of the second; leaves store the range of their primitives.
+struct alignas(32) linear_bvh_node {
+    glm::vec3 boundsMin;
+    uint32_t offset;            // leaf: first primitive, interior: second child
+    glm::vec3 boundsMax;
+    uint16_t primitiveCount;    // 0 for interior nodes
+    uint8_t axis;
+    uint8_t pad;
+};
+static_assert(sizeof(linear_bvh_node) == 32, "linear_bvh_node must stay one half cache line");
+
+// Flattened SAH hierarchy over a set of boxes. Users reorder their primitives by order() so that
+// every leaf covers a contiguous range, and supply the leaf intersection to traverse().
+class bvh_tree
+{
+public:
+    static constexpr int max_depth = 64;
+
+    // leafBatch is the number of primitives a leaf intersects for the price of one (the SIMD width
+    // of a batched leaf kernel); the SAH leaf cost is charged per batch.
+    void build(const vector<aabb>& boxes, int maxLeafSize = 4, int leafBatch = 1);
+    const vector<uint32_t>& order() const { return primitiveOrder; }
+    const vector<linear_bvh_node>& getNodes() const { return nodes; }
+    aabb bounds() const;
+
+    // leaf(first, count, t_max) intersects primitives [first, first + count), shrinks t_max to the
+    // closest hit and returns whether it found one. With AnyHit the traversal stops at the first
+    // leaf reporting a hit, which is all an occlusion query needs.
+    template<bool AnyHit = false, typename LeafFn>
+    bool traverse(const ray& r, double t_min, double t_max, LeafFn&& leaf) const;
+
+private:
+    uint32_t build_recursive(const vector<aabb>& boxes, size_t begin, size_t end, int depth);
+    vector<linear_bvh_node> nodes;
+    vector<uint32_t> primitiveOrder;
+    int leafSize = 4;
+    int leafBatch = 1;
+};
+
+template<bool AnyHit, typename LeafFn>
+inline bool bvh_tree::traverse(const ray& r, double t_min, double t_max, LeafFn&& leaf) const
+{
+    if (nodes.empty()) return false;
+    const glm::vec3 o = r.origin();
+    const glm::vec3 d = r.direction();
+    const float orig[3] = { o.x, o.y, o.z };
+    const float invDir[3] = { 1.f / d.x, 1.f / d.y, 1.f / d.z };
+    const bool dirIsNeg[3] = { invDir[0] < 0, invDir[1] < 0, invDir[2] < 0 };
+
+    uint32_t stack[max_depth];
+    int stackSize = 0;
+    uint32_t current = 0;
+    uint64_t visited = 0;
+    bool hitAnything = false;
+    while (true)
+    {
+        const linear_bvh_node& node = nodes[current];
+        visited++;
+        const float* nearX = dirIsNeg[0] ? &node.boundsMax.x : &node.boundsMin.x;
+        const float* farX = dirIsNeg[0] ? &node.boundsMin.x : &node.boundsMax.x;
+        const float* nearY = dirIsNeg[1] ? &node.boundsMax.y : &node.boundsMin.y;
+        const float* farY = dirIsNeg[1] ? &node.boundsMin.y : &node.boundsMax.y;
+        const float* nearZ = dirIsNeg[2] ? &node.boundsMax.z : &node.boundsMin.z;
+        const float* farZ = dirIsNeg[2] ? &node.boundsMin.z : &node.boundsMax.z;
+        float near = std::max(std::max((*nearX - orig[0]) * invDir[0], (*nearY - orig[1]) * invDir[1]),
+            std::max((*nearZ - orig[2]) * invDir[2], static_cast<float>(t_min)));
+        float far = std::min(std::min((*farX - orig[0]) * invDir[0], (*farY - orig[1]) * invDir[1]),
+            std::min((*farZ - orig[2]) * invDir[2], static_cast<float>(t_max)));
+        if (near <= far)
+        {
+            if (node.primitiveCount > 0)
+            {
+                if (leaf(node.offset, static_cast<uint32_t>(node.primitiveCount), t_max))
+                {
+                    hitAnything = true;
+                    if constexpr (AnyHit) break;
+                }
+            }
+            else
+            {
+                // visit the child on the near side of the split plane first
+                if (dirIsNeg[node.axis])
+                {
+                    stack[stackSize++] = current + 1;
+                    current = node.offset;
+                }
+                else
+                {
+                    stack[stackSize++] = node.offset;
+                    current = current + 1;
+                }
+                continue;
+            }
+        }
+        if (stackSize == 0) break;
+        current = stack[--stackSize];
+    }
+    auto& stats = thread_traversal_stats();
+    stats.rays++;
+    stats.nodesVisited += visited;
+    return hitAnything;
+}
+
+// Hittable over a primitive_set, with Tree (bvh_tree or wide_bvh_tree<N>) built over its bounded
+// primitives. Leaves index primitive_set's per-type arrays, permuted into leaf order, so traversal
+// of the built-in types touches no shared_ptr; only custom objects are reached through one.
+// Unbounded primitives are tested outside the tree.
+template<typename Tree>
+class bvh_accelerator : public hittable
+{
+public:
+    explicit bvh_accelerator(const hittable_list& list, int maxLeafSize = 4);
+    virtual bool intersect(const ray& r, double t_min, double t_max, hit_id& id) const override;
+    virtual void materialize(const ray& r, const hit_id& id, hit_record& rec) const override;
+    virtual bool occluded(const ray& r, double t_min, double t_max) const override;
+    virtual bool bounding_box(aabb& output_box) const override;
+private:
+    Tree tree;
+    primitive_set primitives;
+};
+
+template<typename Tree>
+inline bvh_accelerator<Tree>::bvh_accelerator(const hittable_list& list, int maxLeafSize)
+    : primitives(list)
+{
+    vector<aabb> boxes = primitives.bounded_boxes();
+    tree.build(boxes, maxLeafSize);
+    primitives.permute(tree.order());
+}
+
+template<typename Tree>
+inline bool bvh_accelerator<Tree>::intersect(const ray& r, double t_min, double t_max, hit_id& id) const
+{
+    // unbounded primitives (ground planes) first: a hit there shortens the ray for the traversal
+    bool hitUnbounded = primitives.intersect_unbounded(r, t_min, t_max, id);
+    if (hitUnbounded)
+        t_max = id.t;
+    return tree.traverse(r, t_min, t_max, [&](uint32_t first, uint32_t count, double& far) {
+        bool hitLeaf = false;
+        for (uint32_t i = first; i < first + count; i++)
+        {
+            if (primitives.intersect(i, r, t_min, far, id))
+            {
+                hitLeaf = true;
+                far = id.t;
+            }
+        }
+        return hitLeaf;
+    }) || hitUnbounded;
+}
+
+template<typename Tree>
+inline void bvh_accelerator<Tree>::materialize(const ray& r, const hit_id& id, hit_record& rec) const
+{
+    id.prim->materialize(r, id, rec);
+}
+
+template<typename Tree>
+inline bool bvh_accelerator<Tree>::occluded(const ray& r, double t_min, double t_max) const
+{
+    if (primitives.occluded_unbounded(r, t_min, t_max))
+        return true;
+    return tree.template traverse<true>(r, t_min, t_max, [&](uint32_t first, uint32_t count, double& far) {
+        for (uint32_t i = first; i < first + count; i++)
+        {
+            if (primitives.occluded(i, r, t_min, far))
+                return true;
+        }
+        return false;
+    });
+}
+
+template<typename Tree>
+inline bool bvh_accelerator<Tree>::bounding_box(aabb& output_box) const
+{
+    output_box = tree.bounds();
+    return !output_box.empty() && primitives.bounded_count() == primitives.size();
+}
+
+using linear_bvh = bvh_accelerator<bvh_tree>;
+
+#endif
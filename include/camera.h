@@ -4,6 +4,8 @@
 #include "glm/glm.hpp"
 #include <glm/gtc/matrix_transform.hpp>
 #include "ray.h"
+#include "rtweekend.h"
+#include "sampler.h"
 using namespace glm;
 
 class camera
@@ -15,7 +17,7 @@ public:
 		lowerLeftCornerLocal(getLLCL())	{}
 	void setEye(const vec3&);
 	void setCenter(const vec3&);
-	virtual ray getRayFromScreenPos(double u, double v);
+	virtual ray getRayFromScreenPos(double u, double v, rtweekend::sampler& rng) const;
 protected:
 	vec3 getLLCL();
 	void updateCamera();
@@ -29,54 +31,14 @@ protected:
 	vec3 lowerLeftCornerLocal;
 };
 
-inline vec3 camera::getLLCL()
-{
-	return vec3(-screenWidth / 2, .0f, .0f) + vec3(.0f, -screenHeight / 2, .0f) + vec3(.0f, .0f, -focalLength);
-}
-
-
-inline void camera::setEye(const vec3& e)
-{
-	eye = e;
-	updateCamera();
-}
-
-
-inline void camera::setCenter(const vec3& c)
-{
-	center = c;
-	updateCamera();
-}
-
-inline void camera::updateCamera()
-{
-	viewToWorld = inverse(lookAt(eye, center, up));
-	lowerLeftCornerLocal = getLLCL();
-}
-
-inline ray camera::getRayFromScreenPos(double u, double v)
-{
-	auto pixelPosLocal = lowerLeftCornerLocal + vec3(0.f, u * screenHeight, 0.f) + vec3(v * screenWidth, 0.f, 0.f);
-	return ray(eye, vec3(viewToWorld * vec4(pixelPosLocal, 1.0f))-eye);
-}
-
 class blurcamera: public camera
 {
 public:
 	blurcamera(const vec3& e, const vec3& c, const vec3& u, double focal, double width, double height, double aperture):
 			camera(e, c, u, focal, width, height), lensRadius(aperture/2) {}
-	ray getRayFromScreenPos(double u, double v) override;
+	ray getRayFromScreenPos(double u, double v, rtweekend::sampler& rng) const override;
 protected:
 	double lensRadius;
 };
 
-inline ray blurcamera::getRayFromScreenPos(double u, double v)
-{
-	vec3 rd = static_cast<float>(lensRadius) * rtweekend::random_in_unit_disk();
-	vec3 offset = vec3(rd.x * u, rd.y * v, 0.f);
-	auto pixelPosLocal = lowerLeftCornerLocal + vec3(0.f, u * screenHeight, 0.f) + vec3(v * screenWidth, 0.f, 0.f);
-	return ray(eye + offset, vec3(viewToWorld * vec4(pixelPosLocal, 1.0f)) - eye - offset);
-}
-
-
 #endif
\ No newline at end of file
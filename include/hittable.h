@@ -2,6 +2,9 @@
 #define HITTABLE_H
 
 #include "ray.h"
+#include "aabb.h"
+#include <cmath>
+#include <cstdint>
 #include <memory>
 #include <vector>
 
@@ -10,12 +13,23 @@ using std::make_shared;
 using std::vector;
 
 class material;
+struct material_record;
 
+class hittable;
+
+// Marks a by-value primitive that was not copied from an emitter.
+constexpr uint32_t no_emitter = 0xffffffffu;
+
+// pMat is non-owning: material records are owned by the primitives (or the scene) that reference
+// them, so filling and copying records never touches a reference count.
 struct hit_record {
     glm::vec3 p;
     glm::vec3 normal;
-    shared_ptr<material> pMat;
+    const material_record* pMat;
     double t;
+    // The front-end object an emissive hit came from, which light_list recognizes; null for
+    // everything else. hit() clears it, so primitives that never emit need not touch it.
+    const hittable* emitter = nullptr;
     bool front_face;
 
 	void set_face_normal(const ray& r, const glm::vec3& outward_normal) {
@@ -24,30 +38,48 @@ struct hit_record {
     }
 };
 
-class hittable {
-public:
-    virtual bool hit(const ray& r, double t_min, double t_max, hit_record& rec) const = 0;
+// Nearest hit found during traversal: the distance plus the primitive (and an index inside it, for
+// primitives that store many shapes) that can rebuild the full hit_record.
+struct hit_id {
+    double t;
+    const hittable* prim;
+    uint32_t index;
 };
 
-class sphere: public hittable
-{
-public:
-    sphere(const glm::vec3&, double, shared_ptr<material>);
-    virtual bool hit(const ray&, double, double, hit_record&) const override;
+// Traversal only runs intersect(), which tracks the nearest t and who produced it; position,
+// normal and material are built once by materialize() for the final hit.
+class hittable {
 public:
-    glm::vec3 center;
-    double radius;
-    shared_ptr<material> pMat;
-};
+    // On a hit with t in [t_min, t_max] fills id and returns true. Aggregates forward to their
+    // children, so id.prim is always a leaf primitive.
+    virtual bool intersect(const ray& r, double t_min, double t_max, hit_id& id) const = 0;
+    // Builds the record for an id this primitive returned from intersect().
+    virtual void materialize(const ray& r, const hit_id& id, hit_record& rec) const = 0;
+    virtual bool bounding_box(aabb& output_box) const = 0;
+    // Any-hit query for shadow rays: true if something lies in [t_min, t_max]. Stops at the first
+    // hit it finds and builds no record. The default suits single primitives.
+    virtual bool occluded(const ray& r, double t_min, double t_max) const {
+        hit_id id;
+        return intersect(r, t_min, t_max, id);
+    }
 
-inline sphere::sphere(const glm::vec3& c, double r, shared_ptr<material> pm)
-		: center(c), radius(r), pMat(pm) {}
+    bool hit(const ray& r, double t_min, double t_max, hit_record& rec) const {
+        hit_id id;
+        if (!intersect(r, t_min, t_max, id))
+            return false;
+        rec.emitter = nullptr;
+        id.prim->materialize(r, id, rec);
+        return true;
+    }
+};
 
-inline bool sphere::hit(const ray& r, double t_min, double t_max, hit_record& rec) const
+// Nearest root of |o + t d - center| = radius inside [t_min, t_max]; shared by sphere and the
+// by-value sphere array of primitive_set.
+inline bool intersect_sphere(const glm::vec3& center, double radius, const ray& r, double t_min, double t_max, double& t)
 {
     glm::vec3 oc = r.origin() - center;
     auto a = glm::dot(r.direction(), r.direction());
-	auto halfB = glm::dot(oc, r.direction());
+    auto halfB = glm::dot(oc, r.direction());
     auto c = glm::dot(oc, oc) - radius * radius;
     auto discriminant = halfB * halfB - a * c;
     if (discriminant < 0) { return false; }
@@ -59,42 +91,38 @@ inline bool sphere::hit(const ray& r, double t_min, double t_max, hit_record& re
         if (root < t_min || t_max < root)
             return false;
     }
-    rec.t = root;
-    rec.p = r.at(root);
-    glm::vec3 outward_normal = (rec.p - center) / static_cast<float>(radius);
-    rec.set_face_normal(r, outward_normal);
-    rec.pMat = pMat;
+    t = root;
     return true;
 }
 
+class sphere: public hittable
+{
+public:
+    sphere(const glm::vec3&, double, shared_ptr<material>);
+    virtual bool intersect(const ray&, double, double, hit_id&) const override;
+    virtual void materialize(const ray&, const hit_id&, hit_record&) const override;
+    virtual bool occluded(const ray&, double, double) const override;
+    virtual bool bounding_box(aabb&) const override;
+public:
+    glm::vec3 center;
+    double radius;
+    shared_ptr<material> pMat;
+};
+
 class hittable_list : public hittable
 {
 public:
     hittable_list() = default;
     hittable_list(shared_ptr<hittable> obj) { add(obj); }
-	virtual bool hit(const ray& r, double t_min, double t_max, hit_record& rec) const override;
+    virtual bool intersect(const ray& r, double t_min, double t_max, hit_id& id) const override;
+    virtual void materialize(const ray& r, const hit_id& id, hit_record& rec) const override;
+    virtual bool occluded(const ray& r, double t_min, double t_max) const override;
+    virtual bool bounding_box(aabb& output_box) const override;
     void add(shared_ptr<hittable> obj) { objects.push_back(obj); }
     void clear() { objects.clear(); }
+    const vector<shared_ptr<hittable>>& getObjects() const { return objects; }
 private:
     vector<shared_ptr<hittable>> objects;
 };
 
-inline bool hittable_list::hit(const ray& r, double t_min, double t_max, hit_record& rec) const
-{
-    bool hitAnything = false;
-    hit_record tempRecord;
-    double far = t_max;
-	for(auto obj : objects)
-	{
-		if(obj->hit(r, t_min, far, tempRecord))
-		{
-            hitAnything = true;
-            rec = tempRecord;
-            far = tempRecord.t;
-		}
-	}
-    return hitAnything;
-}
-
-
 #endif
\ No newline at end of file
@@ -0,0 +1,31 @@
+#ifndef IMAGE_IO_H_
+#define IMAGE_IO_H_
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+#include "glm/glm.hpp"
+
+// Writers for the linear RGB images produced by renderer (row 0 at the bottom). PPM and PNG are
+// 8-bit with gamma 2, PFM keeps the raw floats.
+namespace image_io
+{
+    inline unsigned char encode_gamma(float linear)
+    {
+        float c = std::sqrt(std::max(linear, 0.f));
+        return static_cast<unsigned char>(std::min(c, 1.f) * 255.f);
+    }
+
+    // top-to-bottom 8-bit RGB rows, the order PPM and PNG expect
+    std::vector<unsigned char> to_rgb8(int width, int height, const std::vector<glm::vec3>& image);
+
+    bool write_ppm(const std::string& path, int width, int height, const std::vector<glm::vec3>& image);
+    bool write_pfm(const std::string& path, int width, int height, const std::vector<glm::vec3>& image);
+    // PNG with an uncompressed (stored) zlib stream, so no zlib dependency is needed.
+    bool write_png(const std::string& path, int width, int height, const std::vector<glm::vec3>& image);
+    // Picks the format from the file extension (.ppm, .png or .pfm).
+    bool write_image(const std::string& path, int width, int height, const std::vector<glm::vec3>& image);
+}
+
+#endif
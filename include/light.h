@@ -0,0 +1,53 @@
+#ifndef LIGHT_H
+#define LIGHT_H
+
+#include "hittable.h"
+#include "sampler.h"
+#include <vector>
+
+struct sphere_light {
+    glm::vec3 center;
+    float radius;
+    glm::vec3 radiance;
+};
+
+// A direction toward a light and what arrives along it, if nothing is in the way.
+struct light_sample {
+    glm::vec3 direction;    // unit length
+    double distance;        // to the light's surface along direction
+    glm::vec3 radiance;
+    float pdf;              // solid angle density, light selection included
+};
+
+// The emitters of a scene, gathered once while it is built, for next-event estimation.
+class light_list
+{
+public:
+    light_list() = default;
+    // Every sphere of the scene with a diffuse_light material, including those in nested
+    // hittable_lists; a sphere added to the scene more than once is one light. Emissive planes,
+    // disks, quads and spheres inside other aggregates are not sampled, only found by BSDF
+    // sampling. The scene is not modified, and the list may be built before or after the
+    // accelerators: lights are recognized by the front-end sphere hits report as their emitter.
+    explicit light_list(const hittable_list& scene);
+
+    // s must be emissive
+    void add(shared_ptr<const sphere> s);
+    bool empty() const { return lights.empty(); }
+    size_t size() const { return lights.size(); }
+
+    // Picks a light uniformly and a direction toward it from p, uniform over the cone the sphere
+    // subtends. Reads the sampler's dim_light_select and dim_light slots of the current bounce.
+    // Returns false when p lies inside the light.
+    bool sample(const glm::vec3& p, rtweekend::sampler& rng, light_sample& s) const;
+    // Density with which sample() from p picks a direction toward emitter, the object a hit
+    // reports in hit_record::emitter. 0 for emitters not in this list. The lookup is a linear
+    // scan, meant for the handful of lights a scene has.
+    float pdf(const hittable* emitter, const glm::vec3& p) const;
+
+private:
+    std::vector<sphere_light> lights;
+    std::vector<shared_ptr<const sphere>> sources;  // parallel to lights
+};
+
+#endif
@@ -2,99 +2,100 @@
 #define MATERIAL_H_
 
 #include "hittable.h"
+#include "rtweekend.h"
+#include "sampler.h"
 #include "glm/glm.hpp"
+#include <cstdint>
+#include <unordered_map>
 
 using namespace glm;
 
+// Materials are stored as compact records (type tag plus parameters) and scattered through one
+// switch, so there is no virtual call per bounce and tables of records stay contiguous. The
+// classes below only build records while the scene is constructed.
+enum class material_type : uint8_t { lambertian, metal, fuzzy_metal, dielectric, diffuse_light };
+
+struct material_record
+{
+	vec3 albedo;		// emitted radiance for diffuse_light
+	float param;		// lobe exponent for fuzzy_metal, index of refraction for dielectric
+	material_type type;
+};
+
+bool scatter(const material_record& mat, const ray& rIn, const hit_record& record, vec3& attenuation, ray& scattered, rtweekend::sampler& rng);
+
+// Solid angle density with which scatter() picks direction (unit length), and the BSDF times the
+// cosine for it, so evaluate() / pdf() is the attenuation scatter() reports. Both are 0 for the
+// delta materials (metal, dielectric) and for emitters.
+float pdf(const material_record& mat, const ray& rIn, const hit_record& record, const vec3& direction);
+vec3 evaluate(const material_record& mat, const ray& rIn, const hit_record& record, const vec3& direction);
+
+// Whether scatter() draws from a density pdf() describes, i.e. whether light sampling applies.
+inline bool has_pdf(const material_record& mat)
+{
+	return mat.type == material_type::lambertian || mat.type == material_type::fuzzy_metal;
+}
+
+inline vec3 emitted(const material_record& mat)
+{
+	return mat.type == material_type::diffuse_light ? mat.albedo : vec3(0.f);
+}
+
 class material
 {
 public:
-	virtual bool scatter(
-		const ray& rIn, const hit_record& record, vec3& attenuation, ray& scattered
-	) const = 0;
+	const material_record& getRecord() const { return record; }
+protected:
+	material(material_type type, const vec3& albedo, float param) : record{ albedo, param, type } {}
+	material_record record;
 };
 
 class lambertian: public material
 {
 public:
 	lambertian(const vec3&);
-	virtual bool scatter(const ray& rIn, const hit_record& rec, vec3& attenuation, ray& scattered) const override;
-private:
-	vec3 albeo;
 };
 
-inline lambertian::lambertian(const vec3& color): material(), albeo(color) {}
-
-
-inline bool lambertian::scatter(const ray& rIn, const hit_record& record, vec3& attenuation, ray& scattered) const
-{
-	vec3 scatteredDirection = rtweekend::random_in_hemisphere(record.normal);
-	scattered = ray(record.p, scatteredDirection);
-	attenuation = albeo;
-	return true;
-}
-
 class metal: public material
 {
 public:
 	metal(const vec3&);
-	virtual bool scatter(const ray& rIn, const hit_record& record, vec3& attenuation, ray& scattered) const override;
 protected:
-	vec3 albeo;
+	metal(material_type type, const vec3& color, float param);
 };
 
-inline metal::metal(const vec3& color) :albeo(color) {}
-
-
-inline bool metal::scatter(const ray& rIn, const hit_record& record, vec3& attenuation, ray& scattered) const
-{
-	vec3 scatteredDirection = rtweekend::reflect(glm::normalize(rIn.direction()), record.normal);
-	scattered = ray(record.p, scatteredDirection);
-	attenuation = albeo;
-	return true;
-}
-
+// Glossy metal: directions follow a normalized Phong lobe cos^n around the mirror direction, with
+// n = 5 / fuzz^2 so the lobe's angular spread stays close to fuzz radians. Fuzz 0 is a mirror.
 class FuzzyMetal: public metal
 {
 public:
 	FuzzyMetal(const vec3&, double);
-	virtual bool scatter(const ray& rIn, const hit_record& record, vec3& attenuation, ray& scattered) const override;
-protected:
-	double fuzzy;
 };
 
-inline FuzzyMetal::FuzzyMetal(const vec3& color, double f): metal(color), fuzzy(f) {}
+class dielectric : public material {
+public:
+	dielectric(double index_of_refraction) : material(material_type::dielectric, vec3(1.0, 1.0, 1.0), static_cast<float>(index_of_refraction)) {}
+};
 
-inline bool FuzzyMetal::scatter(const ray& rIn, const hit_record& record, vec3& attenuation, ray& scattered) const
+// Emits radiance uniformly from both sides and scatters nothing.
+class diffuse_light : public material
 {
-	vec3 scatteredDirection = rtweekend::reflect(glm::normalize(rIn.direction()), record.normal);
-	scattered = ray(record.p, scatteredDirection + static_cast<float>(fuzzy) * rtweekend::random_in_hemisphere(scatteredDirection));
-	attenuation = albeo;
-	return true;
-}
-
-class dielectric : public material {
 public:
-	dielectric(double index_of_refraction) : material(), ir(index_of_refraction) {}
-
-	virtual bool scatter(
-		const ray& rIn, const hit_record& record, vec3& attenuation, ray& scattered
-	) const override {
-		attenuation = vec3(1.0, 1.0, 1.0);
-		float refraction_ratio = record.front_face ? (1.0 / ir) : ir;
-		vec3 unit_direction = normalize(rIn.direction());
-		float cos_theta = fmin(dot(-unit_direction, record.normal), 1.0);
-		float sin_theta = sqrt(1.0 - cos_theta * cos_theta);
-		bool cannot_refract = refraction_ratio * sin_theta > 1.0;
-		vec3 direction;
-		if (cannot_refract) { direction = rtweekend::reflect(unit_direction, record.normal); }
-		else { direction = rtweekend::refract(unit_direction, record.normal, refraction_ratio); }
-		scattered = ray(record.p, direction);
-		return true;
-	}
+	diffuse_light(const vec3& emit) : material(material_type::diffuse_light, emit, 0.f) {}
+};
 
-protected:
-	double ir; // Index of Refraction
+// The records of an accelerator's materials, one per distinct front-end material. add() dedupes
+// by address; the table holds the materials it saw so those addresses stay unique.
+class material_table
+{
+public:
+	uint32_t add(const shared_ptr<material>& mat);
+	const material_record& operator[](uint32_t id) const { return records[id]; }
+	size_t size() const { return records.size(); }
+private:
+	vector<material_record> records;
+	std::unordered_map<const material*, uint32_t> index;
+	vector<shared_ptr<material>> owners;
 };
 
 #endif
@@ -0,0 +1,102 @@
+#ifndef PLANAR_H
+#define PLANAR_H
+
+#include "hittable.h"
+#include <cmath>
+
+// Flat primitives. The shape structs hold only geometry and are stored by value in primitive_set;
+// plane, disk and quad are the hittable front ends used while building a hittable_list.
+
+// Infinite plane dot(normal, p) = offset; normal is unit length.
+struct plane_shape {
+    glm::vec3 normal;
+    float offset;
+
+    bool intersect(const ray& r, double t_min, double t_max, double& t) const {
+        float denom = glm::dot(normal, r.direction());
+        if (std::fabs(denom) < 1e-8f) return false;
+        double root = (offset - glm::dot(normal, r.origin())) / denom;
+        if (root < t_min || t_max < root) return false;
+        t = root;
+        return true;
+    }
+};
+
+// Disk of radius sqrt(radius2) around center, lying in the plane through center.
+struct disk_shape {
+    plane_shape support;
+    glm::vec3 center;
+    float radius2;
+
+    bool intersect(const ray& r, double t_min, double t_max, double& t) const {
+        double root;
+        if (!support.intersect(r, t_min, t_max, root)) return false;
+        glm::vec3 d = r.at(root) - center;
+        if (glm::dot(d, d) > radius2) return false;
+        t = root;
+        return true;
+    }
+    aabb box() const;
+};
+
+// Parallelogram corner + a * u + b * v for a, b in [0, 1]. w = n / dot(n, n) with n = cross(u, v)
+// turns a point of the plane into its (a, b) coordinates.
+struct quad_shape {
+    plane_shape support;
+    glm::vec3 corner, u, v, w;
+
+    bool intersect(const ray& r, double t_min, double t_max, double& t) const {
+        double root;
+        if (!support.intersect(r, t_min, t_max, root)) return false;
+        glm::vec3 p = r.at(root) - corner;
+        float a = glm::dot(w, glm::cross(p, v));
+        float b = glm::dot(w, glm::cross(u, p));
+        if (a < 0.f || a > 1.f || b < 0.f || b > 1.f) return false;
+        t = root;
+        return true;
+    }
+    aabb box() const;
+};
+
+plane_shape make_plane_shape(const glm::vec3& point, const glm::vec3& normal);
+disk_shape make_disk_shape(const glm::vec3& center, const glm::vec3& normal, float radius);
+quad_shape make_quad_shape(const glm::vec3& corner, const glm::vec3& u, const glm::vec3& v);
+
+// An infinite plane has no bounding box; the BVHs test it on every ray before traversal.
+class plane : public hittable
+{
+public:
+    plane(const glm::vec3& point, const glm::vec3& normal, shared_ptr<material> m);
+    virtual bool intersect(const ray& r, double t_min, double t_max, hit_id& id) const override;
+    virtual void materialize(const ray& r, const hit_id& id, hit_record& rec) const override;
+    virtual bool bounding_box(aabb& output_box) const override;
+public:
+    plane_shape shape;
+    shared_ptr<material> pMat;
+};
+
+class disk : public hittable
+{
+public:
+    disk(const glm::vec3& center, const glm::vec3& normal, float radius, shared_ptr<material> m);
+    virtual bool intersect(const ray& r, double t_min, double t_max, hit_id& id) const override;
+    virtual void materialize(const ray& r, const hit_id& id, hit_record& rec) const override;
+    virtual bool bounding_box(aabb& output_box) const override;
+public:
+    disk_shape shape;
+    shared_ptr<material> pMat;
+};
+
+class quad : public hittable
+{
+public:
+    quad(const glm::vec3& corner, const glm::vec3& u, const glm::vec3& v, shared_ptr<material> m);
+    virtual bool intersect(const ray& r, double t_min, double t_max, hit_id& id) const override;
+    virtual void materialize(const ray& r, const hit_id& id, hit_record& rec) const override;
+    virtual bool bounding_box(aabb& output_box) const override;
+public:
+    quad_shape shape;
+    shared_ptr<material> pMat;
+};
+
+#endif
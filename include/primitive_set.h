@@ -0,0 +1,118 @@
+#ifndef PRIMITIVE_SET_H
+#define PRIMITIVE_SET_H
+
+#include "hittable.h"
+#include "material.h"
+#include "planar.h"
+
+// The closed set of built-in primitive types. Each one lives by value in its own array of
+// primitive_set; anything else goes through the virtual hittable interface as `custom`.
+enum class primitive_type : uint8_t { sphere, plane, disk, quad, custom };
+
+struct sphere_primitive {
+    glm::vec3 center;
+    double radius;
+    uint32_t material;
+    uint32_t emitter;   // into primitive_set's emitters, or no_emitter
+};
+
+template<typename Shape>
+struct flat_primitive {
+    Shape shape;
+    uint32_t material;
+};
+
+// Flat primitive storage for the BVHs. Built-in types are dispatched through a switch on the type
+// tag and stored contiguously per type, with their materials in one record table. Custom
+// hittables stay reachable through a virtual call, which is the slower path.
+class primitive_set : public hittable
+{
+public:
+    primitive_set() = default;
+    // Spheres, planes, disks and quads are copied into their arrays, every other object is kept
+    // as a custom primitive.
+    explicit primitive_set(const hittable_list& list);
+
+    // source is the shared front-end object; when s is emissive it is kept and reported as
+    // hit_record::emitter, so a light_list built from the same scene recognizes the hits.
+    void add(const sphere& s, shared_ptr<const hittable> source = nullptr);
+    void add(const plane& p);
+    void add(const disk& d);
+    void add(const quad& q);
+    void add_custom(shared_ptr<hittable> obj);
+
+    size_t size() const { return refs.size(); }
+    // false for primitives without bounds (infinite planes)
+    bool primitive_box(uint32_t i, aabb& box) const;
+
+    // BVH build support: moves the unbounded primitives behind the bounded ones and returns the
+    // boxes of the bounded ones. A tree is built over those boxes, then permute(tree.order())
+    // puts the bounded primitives in leaf order; unbounded ones are tested by intersect_unbounded.
+    vector<aabb> bounded_boxes();
+    size_t bounded_count() const { return boundedCount; }
+    // reorders primitives [0, order.size()) so that primitive i becomes the former order[i]
+    void permute(const vector<uint32_t>& order);
+    bool intersect_unbounded(const ray& r, double t_min, double t_max, hit_id& id) const;
+    bool occluded_unbounded(const ray& r, double t_min, double t_max) const;
+
+    // Nearest-hit test of primitive i alone; the same contract as hittable::intersect.
+    bool intersect(uint32_t i, const ray& r, double t_min, double t_max, hit_id& id) const {
+        const primitive_ref& ref = refs[i];
+        double t;
+        bool hit;
+        switch (ref.type)
+        {
+        case primitive_type::sphere:
+            hit = intersect_sphere(spheres[ref.index].center, spheres[ref.index].radius, r, t_min, t_max, t);
+            break;
+        case primitive_type::plane:
+            hit = planes[ref.index].shape.intersect(r, t_min, t_max, t);
+            break;
+        case primitive_type::disk:
+            hit = disks[ref.index].shape.intersect(r, t_min, t_max, t);
+            break;
+        case primitive_type::quad:
+            hit = quads[ref.index].shape.intersect(r, t_min, t_max, t);
+            break;
+        default:
+            return custom[ref.index]->intersect(r, t_min, t_max, id);
+        }
+        if (hit)
+            id = { t, this, i };
+        return hit;
+    }
+
+    // Any-hit test of primitive i alone. Built-in types have a single hit to find, so only custom
+    // primitives need their own occluded().
+    bool occluded(uint32_t i, const ray& r, double t_min, double t_max) const {
+        const primitive_ref& ref = refs[i];
+        if (ref.type == primitive_type::custom)
+            return custom[ref.index]->occluded(r, t_min, t_max);
+        hit_id id;
+        return intersect(i, r, t_min, t_max, id);
+    }
+
+    // Brute-force test against every primitive.
+    virtual bool intersect(const ray& r, double t_min, double t_max, hit_id& id) const override;
+    virtual void materialize(const ray& r, const hit_id& id, hit_record& rec) const override;
+    virtual bool occluded(const ray& r, double t_min, double t_max) const override;
+    virtual bool bounding_box(aabb& output_box) const override;
+
+private:
+    struct primitive_ref {
+        primitive_type type;
+        uint32_t index;     // into the array of its type
+    };
+
+    vector<primitive_ref> refs;
+    size_t boundedCount = 0;
+    vector<sphere_primitive> spheres;
+    vector<flat_primitive<plane_shape>> planes;
+    vector<flat_primitive<disk_shape>> disks;
+    vector<flat_primitive<quad_shape>> quads;
+    vector<shared_ptr<hittable>> custom;
+    vector<shared_ptr<const hittable>> emitters;
+    material_table materials;
+};
+
+#endif
@@ -0,0 +1,208 @@
+#ifndef RENDERER_H_
+#define RENDERER_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "glm/glm.hpp"
+#include "ray.h"
+#include "hittable.h"
+#include "bvh.h"
+#include "camera.h"
+#include "material.h"
+#include "light.h"
+#include "sampler.h"
+#include "thread_pool.h"
+
+struct render_settings {
+    int width = 1920;
+    int height = 1080;
+    int samples = 500;      // per pixel; the upper bound when adaptive sampling is on
+    int minSamples = 0;     // > 0 enables adaptive sampling, starting every pixel with this many
+    float maxRelError = 0.02f;  // adaptive: stop once the luminance standard error / mean falls below
+    int sampleBatch = 8;    // adaptive: samples taken between convergence checks
+    int maxDepth = 50;      // hard cap on path length
+    int rrMinDepth = 3;     // Russian roulette starts after this many scatters, < 0 disables it
+    unsigned threads = 0;   // 0 picks hardware_concurrency
+    int tileSize = 32;
+    rtweekend::sampler_type samplerType = rtweekend::sampler_type::independent;
+    bool sampleLights = true;   // next-event estimation toward the lights given to setLights()
+    float skyIntensity = 1.f;   // scales the background gradient
+};
+
+// Camera paths traced, segments (hit queries) along them and shadow rays toward lights.
+struct path_stats {
+    uint64_t paths = 0;
+    uint64_t segments = 0;
+    uint64_t shadowRays = 0;
+
+    double average_length() const { return paths ? static_cast<double>(segments) / paths : 0.0; }
+};
+
+// Iterative path tracer: carries the path throughput through up to maxDepth scatters instead of
+// recursing per bounce. A plain struct rather than a std::function so the per-sample call in
+// render_tile is a direct, inlinable call.
+struct path_integrator
+{
+    const hittable& world;
+    const light_list* lights;   // null disables next-event estimation
+    int maxDepth;
+    int rrMinDepth;
+    float skyIntensity;
+    path_stats& stats;
+
+    glm::vec3 background(const ray& r) const
+    {
+        glm::vec3 normDir = glm::normalize(r.direction());
+        float t = 0.5f * (normDir.y + 1);
+        return skyIntensity * (t * glm::vec3(0.5, 0.7, 1.0) + (1 - t) * glm::vec3(1));
+    }
+
+    // Power heuristic (Veach) weight of a strategy with density a against one with density b.
+    static float power_heuristic(float a, float b)
+    {
+        return a * a / (a * a + b * b);
+    }
+
+    // Next-event estimation: one light sample through the BSDF, unless a shadow ray finds the light
+    // blocked. MIS-weighted against the BSDF having sampled the same direction.
+    glm::vec3 direct_light(const material_record& mat, const ray& rIn, const hit_record& record, rtweekend::sampler& rng) const
+    {
+        light_sample light;
+        if (!lights->sample(record.p, rng, light))
+            return glm::vec3(0.f);
+        glm::vec3 f = evaluate(mat, rIn, record, light.direction);
+        if (f == glm::vec3(0.f))
+            return glm::vec3(0.f);
+        ++stats.shadowRays;
+        if (world.occluded(ray(record.p, light.direction), .001, light.distance - .001))
+            return glm::vec3(0.f);
+        float weight = power_heuristic(light.pdf, pdf(mat, rIn, record, light.direction));
+        return f * light.radiance * (weight / light.pdf);
+    }
+
+    // Emitters are reached two ways at every hit with a BSDF density: by next-event estimation
+    // and by the BSDF sample of the next bounce. Multiple importance sampling weights the two
+    // so each covers what it samples well, glossy reflections on one side and small lights on
+    // the other, and the sum stays unbiased.
+    glm::vec3 operator()(ray r, rtweekend::sampler& rng) const
+    {
+        glm::vec3 radiance(0.f);
+        glm::vec3 throughput(1.f);
+        hit_record record;
+        // density of the BSDF sample that produced r, 0 for camera rays and delta bounces, whose
+        // emitter hits light sampling could not have produced
+        float bsdfPdf = 0.f;
+        glm::vec3 origin(0.f);
+        ++stats.paths;
+        for (int bounce = 0; bounce < maxDepth; ++bounce)
+        {
+            ++stats.segments;
+            if (!world.hit(r, .001, std::numeric_limits<double>::infinity(), record))
+                return radiance + throughput * background(r);
+            const material_record& mat = *record.pMat;
+            glm::vec3 emission = emitted(mat);
+            if (emission != glm::vec3(0.f))
+            {
+                // only emitters in the light list compete with light sampling; the rest are found
+                // by BSDF sampling alone and keep their full weight
+                float weight = lights && bsdfPdf > 0.f && record.emitter
+                    ? power_heuristic(bsdfPdf, lights->pdf(record.emitter, origin)) : 1.f;
+                radiance += throughput * emission * weight;
+            }
+            glm::vec3 attenuation;
+            ray scattered;
+            rng.start_bounce(bounce + 1);
+            const bool sampleLights = lights && has_pdf(mat);
+            if (sampleLights)
+                radiance += throughput * direct_light(mat, r, record, rng);
+            rng.seek(rtweekend::sampler::dim_bsdf);
+            if (!scatter(mat, r, record, attenuation, scattered, rng))
+                return radiance;
+            bsdfPdf = sampleLights ? pdf(mat, r, record, glm::normalize(scattered.direction())) : 0.f;
+            origin = record.p;
+            throughput *= attenuation;
+            r = scattered;
+            rng.seek(rtweekend::sampler::dim_roulette);
+            // Russian roulette: continue with probability equal to the largest throughput component
+            // and divide by it, so dim paths end early without biasing the estimate.
+            if (rrMinDepth >= 0 && bounce + 1 >= rrMinDepth)
+            {
+                float survive = std::min(std::max(throughput.x, std::max(throughput.y, throughput.z)), 1.f);
+                if (rng.next_double() >= survive)
+                    return radiance;
+                throughput /= survive;
+            }
+        }
+        return radiance;
+    }
+};
+
+// Running per-pixel sums for progressive rendering, same layout as the rendered images.
+struct accumulation_buffer
+{
+    int width = 0;
+    int height = 0;
+    std::vector<glm::vec3> sum;
+    std::vector<uint32_t> count;
+
+    void reset(int w, int h);
+    glm::vec3 average(size_t pixel) const { return count[pixel] ? sum[pixel] / static_cast<float>(count[pixel]) : glm::vec3(0.f); }
+};
+
+// Tile-parallel renderer shared by the viewer and the headless executable. Images are linear RGB,
+// width * height pixels with row 0 at the bottom.
+class renderer
+{
+public:
+    explicit renderer(const render_settings& settings);
+
+    const render_settings& getSettings() const { return config; }
+    unsigned thread_count() const { return pool.size(); }
+
+    void render(const hittable& world, const camera& cam, std::vector<glm::vec3>& image);
+    // Adds samplesPerPass samples to every pixel of buffer, continuing each pixel's sample sequence
+    // from its current count. Tiles not yet started are skipped once *cancel becomes true.
+    // onTileDone(tile, worker) runs on the worker right after a tile's pixels were updated.
+    void accumulate(const hittable& world, const camera& cam, accumulation_buffer& buffer,
+        int samplesPerPass = 1, const std::atomic<bool>* cancel = nullptr,
+        const thread_pool::task_fn& onTileDone = nullptr);
+
+    size_t tile_count() const { return static_cast<size_t>(tilesX) * tilesY; }
+    // pixel range [x0, x1) x [y0, y1) covered by a tile
+    void tile_bounds(size_t tile, int& x0, int& y0, int& x1, int& y1) const;
+    // traversal counters summed over all workers for the last render() call
+    traversal_stats getStats() const;
+    path_stats getPathStats() const;
+    // Lights for next-event estimation, typically light_list(scene); null (the default) or an
+    // empty list leaves emitters to be found by BSDF sampling alone. Must outlive the renders.
+    void setLights(const light_list* lightList) { lights = lightList; }
+    // samples taken per pixel in the last render(), same layout as the image
+    const std::vector<uint32_t>& getSampleCounts() const { return sampleCounts; }
+
+private:
+    void reset_stats();
+    const light_list* sampled_lights() const { return config.sampleLights && lights && !lights->empty() ? lights : nullptr; }
+    void render_tile(size_t tile, unsigned worker, const hittable& world, const camera& cam, std::vector<glm::vec3>& image);
+    void accumulate_tile(size_t tile, unsigned worker, const hittable& world, const camera& cam, accumulation_buffer& buffer, int samplesPerPass);
+
+    // per-worker state, padded so neighbouring workers never share a cache line. Samples are keyed
+    // on pixel, sample index and bounce, so the image does not depend on the thread count.
+    struct alignas(64) worker_state {
+        rtweekend::sampler rng;
+        traversal_stats stats;
+        path_stats paths;
+    };
+
+    render_settings config;
+    const light_list* lights = nullptr;
+    thread_pool pool;
+    std::vector<worker_state> workers;
+    std::vector<uint32_t> sampleCounts;
+    int tilesX;
+    int tilesY;
+};
+
+#endif
@@ -1,57 +1,146 @@
-#include <random>
+#ifndef RTWEEKEND_H
+#define RTWEEKEND_H
+
+#include <cstdint>
+#include <cmath>
 #include "glm/glm.hpp"
 
 namespace rtweekend
 {
-    inline double random_double() {
-        static std::uniform_real_distribution<double> distribution(0.0, 1.0);
-        static std::mt19937 generator;
-        return distribution(generator);
+    constexpr double pi = 3.1415926535897932385;
+
+    // PCG32 (O'Neill, pcg-random.org): 16 bytes of state, cheap to copy and to own per worker.
+    class pcg32
+    {
+    public:
+        explicit pcg32(uint64_t seed = 0x853c49e6748fea9bULL, uint64_t stream = 0xda3e39cb94b95bdbULL) {
+            state = 0;
+            inc = (stream << 1u) | 1u;
+            next_uint();
+            state += seed;
+            next_uint();
+        }
+
+        uint32_t next_uint() {
+            uint64_t old = state;
+            state = old * 6364136223846793005ULL + inc;
+            auto xorshifted = static_cast<uint32_t>(((old >> 18u) ^ old) >> 27u);
+            auto rot = static_cast<uint32_t>(old >> 59u);
+            return (xorshifted >> rot) | (xorshifted << ((~rot + 1u) & 31u));
+        }
+
+        // uniform in [0, 1)
+        double next_double() {
+            return next_uint() * (1.0 / 4294967296.0);
+        }
+
+    private:
+        uint64_t state;
+        uint64_t inc;
+    };
+
+    // The helpers below accept any generator exposing next_double(): pcg32 for scene
+    // construction, sampler on the rendering path.
+    template<typename Rng>
+    inline double random_double(Rng& rng) {
+        return rng.next_double();
     }
 
-    inline double random_double(double min, double max) {
-        static std::uniform_real_distribution<double> distribution(min, max);
-        static std::mt19937 generator;
-        return distribution(generator);
+    template<typename Rng>
+    inline double random_double(Rng& rng, double min, double max) {
+        return min + (max - min) * rng.next_double();
     }
 
-    glm::vec3 random_in_unit_sphere() {
-        while (true) {
-            auto p = glm::vec3(random_double(-1.0, 1.0), random_double(-1.0, 1.0), random_double(-1.0, 1.0));
-            if (length(p) >= 1) continue;
-            return p;
-        }
+    // The samplers below are closed-form: each draws a fixed number of uniforms (noted per
+    // function) and never loops, so a sample always occupies the same sampler dimensions.
+
+    // Uniform direction, 2 uniforms: z uniform in [-1, 1] and an azimuth (Archimedes' hat-box).
+    template<typename Rng>
+    glm::vec3 random_unit_vector(Rng& rng) {
+        float z = static_cast<float>(1 - 2 * rng.next_double());
+        float phi = static_cast<float>(2 * pi * rng.next_double());
+        float r = std::sqrt(std::fmax(0.f, 1 - z * z));
+        return glm::vec3(r * std::cos(phi), r * std::sin(phi), z);
     }
 
-    glm::vec3 random_unit_vector() {
-        return normalize(random_in_unit_sphere());
+    // Uniform point in the unit ball, 3 uniforms: a direction scaled by the cube root of the third.
+    template<typename Rng>
+    glm::vec3 random_in_unit_sphere(Rng& rng) {
+        glm::vec3 direction = random_unit_vector(rng);
+        return std::cbrt(static_cast<float>(rng.next_double())) * direction;
     }
 
-    glm::vec3 random_in_hemisphere(const glm::vec3& normal) {
-        glm::vec3 in_unit_sphere = random_in_unit_sphere();
+    template<typename Rng>
+    glm::vec3 random_in_hemisphere(Rng& rng, const glm::vec3& normal) {
+        glm::vec3 in_unit_sphere = random_in_unit_sphere(rng);
         if (dot(in_unit_sphere, normal) > 0.0) // In the same hemisphere as the normal
             return in_unit_sphere;
         else
             return -in_unit_sphere;
     }
 
-    glm::vec3 reflect(const glm::vec3& v, const glm::vec3& n)
+    // Orthonormal basis with w along the unit vector n (Duff et al., "Building an Orthonormal
+    // Basis, Revisited"): no normalization and no branch beyond the sign of n.z.
+    struct onb
+    {
+        glm::vec3 u, v, w;
+
+        explicit onb(const glm::vec3& n) : w(n) {
+            float sign = std::copysign(1.f, n.z);
+            float a = -1.f / (sign + n.z);
+            float b = n.x * n.y * a;
+            u = glm::vec3(1.f + sign * n.x * n.x * a, sign * b, -sign * n.x);
+            v = glm::vec3(b, sign + n.y * n.y * a, -n.y);
+        }
+
+        glm::vec3 local(const glm::vec3& a) const {
+            return a.x * u + a.y * v + a.z * w;
+        }
+    };
+
+    // Cosine-weighted direction around +z, pdf cos(theta) / pi, from exactly two uniforms: a
+    // uniform point on the unit disk lifted onto the hemisphere (Malley's method).
+    template<typename Rng>
+    glm::vec3 random_cosine_direction(Rng& rng) {
+        double r1 = rng.next_double();
+        double r2 = rng.next_double();
+        double phi = 2 * pi * r1;
+        double r = std::sqrt(r2);
+        return glm::vec3(r * std::cos(phi), r * std::sin(phi), std::sqrt(1 - r2));
+    }
+
+    inline glm::vec3 reflect(const glm::vec3& v, const glm::vec3& n)
     {
         return v - 2 * dot(v, n) * n;
     }
 
-    glm::vec3 refract(const glm::vec3& uv, const glm::vec3& n, float etai_over_etat) {
+    inline glm::vec3 refract(const glm::vec3& uv, const glm::vec3& n, float etai_over_etat) {
         float cos_theta = fmin(glm::dot(-uv, n), 1.0);
         glm::vec3 r_out_perp = etai_over_etat * (uv + cos_theta * n);
         glm::vec3 r_out_parallel = - static_cast<float>(sqrt(fabs(1.0 - powf(glm::length(r_out_perp), 2)))) * n;
         return r_out_perp + r_out_parallel;
     }
 
-    glm::vec3 random_in_unit_disk() {
-        while (true) {
-            auto p = glm::vec3(random_double(-1, 1), random_double(-1, 1), 0);
-            if (glm::dot(p, p) >= 1) continue;
-            return p;
+    // Uniform point in the unit disk (z = 0), 2 uniforms, by Shirley and Chiu's concentric mapping
+    // of the square onto the disk; it keeps strata intact, unlike the polar sqrt(u) mapping.
+    template<typename Rng>
+    glm::vec3 random_in_unit_disk(Rng& rng) {
+        constexpr float quarter_pi = static_cast<float>(pi / 4);
+        float a = static_cast<float>(2 * rng.next_double() - 1);
+        float b = static_cast<float>(2 * rng.next_double() - 1);
+        if (a == 0 && b == 0)
+            return glm::vec3(0.f);
+        float r, theta;
+        if (std::fabs(a) > std::fabs(b)) {
+            r = a;
+            theta = quarter_pi * (b / a);
         }
+        else {
+            r = b;
+            theta = 2 * quarter_pi - quarter_pi * (a / b);
+        }
+        return glm::vec3(r * std::cos(theta), r * std::sin(theta), 0);
     }
 }
+
+#endif
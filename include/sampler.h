@@ -0,0 +1,125 @@
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <cstdint>
+#include <string>
+
+namespace rtweekend
+{
+    // Philox4x32-10 (Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3"): maps a
+    // 128-bit counter and a 64-bit key to four independent 32-bit outputs, with no state.
+    inline void philox4x32(const uint32_t counter[4], uint32_t key0, uint32_t key1, uint32_t out[4])
+    {
+        uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+        for (int round = 0; round < 10; round++) {
+            uint64_t p0 = static_cast<uint64_t>(0xD2511F53u) * c0;
+            uint64_t p1 = static_cast<uint64_t>(0xCD9E8D57u) * c2;
+            uint32_t n0 = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ key0;
+            uint32_t n2 = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ key1;
+            c1 = static_cast<uint32_t>(p1);
+            c3 = static_cast<uint32_t>(p0);
+            c0 = n0;
+            c2 = n2;
+            key0 += 0x9E3779B9u;
+            key1 += 0xBB67AE85u;
+        }
+        out[0] = c0;
+        out[1] = c1;
+        out[2] = c2;
+        out[3] = c3;
+    }
+
+    // Sample patterns, chosen per render:
+    //  independent  Philox random numbers, no correlation between samples
+    //  stratified   correlated multi-jittered 2D strata over the pixel's sample count (Kensler)
+    //  sobol        Owen-scrambled Sobol (0,2)-sequence, scrambled per pixel (Burley)
+    //  blue_noise   one Owen-scrambled Sobol sequence for all pixels, rotated per pixel by a
+    //               blue-noise offset so the remaining error is spread as high-frequency noise
+    enum class sampler_type : uint8_t { independent, stratified, sobol, blue_noise };
+
+    bool parse_sampler_type(const std::string& name, sampler_type& type);
+
+    // 64x64 tile of blue-noise ranks 0..4095 (void and cluster), generated on first use.
+    constexpr int blue_noise_size = 64;
+    const uint16_t* blue_noise_tile();
+
+    // Counter-based sampler: every value is a pure function of (seed, pixel x, pixel y, sample
+    // index, bounce, dimension), so a pixel renders identically no matter which thread or tile
+    // order produced it. Consumers draw dimensions in a fixed order through next_double().
+    //
+    // Dimensions are allocated per bounce: bounce 0 covers the camera, bounce n the n-th scatter
+    // event. Each decision seek()s to its own slot below, so it reads the same dimensions however
+    // many the previous one consumed. The low-discrepancy patterns stratify the pairs (0, 1),
+    // (2, 3), ... jointly and decorrelate different pairs from each other.
+    class sampler
+    {
+    public:
+        static constexpr uint32_t dim_pixel = 0;     // bounce 0: pixel jitter (2)
+        static constexpr uint32_t dim_lens = 2;      // bounce 0: lens position (2)
+        static constexpr uint32_t dim_bsdf = 0;      // scatter direction (up to 3)
+        static constexpr uint32_t dim_roulette = 3;  // Russian roulette (1)
+        static constexpr uint32_t dim_light = 4;     // point on the chosen light (2)
+        static constexpr uint32_t dim_light_select = 6;  // which light (1)
+
+        explicit sampler(uint32_t seed = 0) : seed(seed) {}
+        // samplesPerPixel sizes the strata of the stratified pattern; samples past it start a new,
+        // independently permuted set of strata.
+        sampler(sampler_type type, int samplesPerPixel, uint32_t seed = 0);
+
+        void start_pixel_sample(int x, int y, int sampleIndex) {
+            px = static_cast<uint32_t>(x);
+            py = static_cast<uint32_t>(y);
+            sample = static_cast<uint32_t>(sampleIndex);
+            start_bounce(0);
+        }
+
+        void start_bounce(int b) {
+            bounce = static_cast<uint32_t>(b);
+            dimension = 0;
+            cachedBlock = invalid_block;
+        }
+
+        void seek(uint32_t d) {
+            dimension = d;
+        }
+
+        uint32_t next_uint() {
+            uint32_t block = dimension >> 2;
+            if (block != cachedBlock) {
+                if (type == sampler_type::independent) {
+                    const uint32_t counter[4] = { px, py, sample, (bounce << 16) | (block & 0xffffu) };
+                    philox4x32(counter, seed, 0x5bd1e995u, values);
+                }
+                else {
+                    fill_pattern(block);
+                }
+                cachedBlock = block;
+            }
+            return values[dimension++ & 3u];
+        }
+
+        // uniform in [0, 1)
+        double next_double() {
+            return next_uint() * (1.0 / 4294967296.0);
+        }
+
+    private:
+        static constexpr uint32_t invalid_block = 0xffffffffu;
+
+        // values of the dimension pairs 2 * block and 2 * block + 1 for the low-discrepancy patterns
+        void fill_pattern(uint32_t block);
+        void stratified_pair(uint32_t pair, uint32_t out[2]) const;
+        void sobol_pair(uint32_t pair, uint32_t out[2]) const;
+
+        sampler_type type = sampler_type::independent;
+        uint32_t seed;
+        uint32_t strataCount = 1, strataColumns = 1, strataRows = 1;
+        const uint16_t* blueNoise = nullptr;
+        uint32_t px = 0, py = 0, sample = 0, bounce = 0;
+        uint32_t dimension = 0;
+        uint32_t cachedBlock = invalid_block;
+        uint32_t values[4] = {};
+    };
+}
+
+#endif
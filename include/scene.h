@@ -0,0 +1,20 @@
+#ifndef SCENE_H_
+#define SCENE_H_
+
+#include <cmath>
+#include "rtweekend.h"
+#include "hittable.h"
+#include "planar.h"
+#include "camera.h"
+#include "material.h"
+
+hittable_list random_scene();
+// random_scene() plus a few small, bright emissive spheres; meant for a dim sky.
+hittable_list random_scene_lights();
+// Uniformly scattered small spheres for acceleration structure benchmarks.
+hittable_list procedural_scene(int count);
+// Camera used for random_scene() and procedural_scene().
+blurcamera random_scene_camera(float aspect_ratio);
+
+#endif
+
@@ -0,0 +1,128 @@
+#ifndef SPHERE_SET_H
+#define SPHERE_SET_H
+
+#include "hittable.h"
+#include "material.h"
+#include "bvh.h"
+#include "wide_bvh.h"
+#include <stdexcept>
+
+// Spheres in structure-of-arrays form: one array per center coordinate, the squared radius and a
+// material id, so one ray can be tested against 8 spheres per AVX iteration. The arrays carry
+// simd_width - 1 padding entries so the kernel may load a full batch past the last sphere.
+class sphere_set : public hittable
+{
+public:
+    static constexpr int simd_width = 8;
+#if defined(RT_HAVE_AVX)
+    static constexpr int leaf_batch = simd_width;
+#else
+    static constexpr int leaf_batch = 1;
+#endif
+
+    sphere_set() = default;
+    // Takes every object of the list, which must all be spheres.
+    explicit sphere_set(const hittable_list& list);
+
+    // source as for primitive_set::add: kept for emissive spheres, reported as hit_record::emitter
+    void add(const glm::vec3& center, float radius, shared_ptr<material> mat, shared_ptr<const hittable> source = nullptr);
+    size_t size() const { return count; }
+    aabb sphere_box(uint32_t index) const;
+    // reorders the spheres so that sphere i becomes the former sphere order[i]
+    void permute(const vector<uint32_t>& order);
+
+    // Nearest hit among spheres [first, first + n) with t in [t_min, t_max]; on a hit t_max is
+    // lowered to it and index names the sphere. No hit_record is built. With anyHit it returns at
+    // the first batch holding a hit, so t_max and index are only meaningful as "some hit".
+    bool intersect_range(const ray& r, uint32_t first, uint32_t n, float t_min, float& t_max, uint32_t& index, bool anyHit = false) const;
+
+    // Brute-force test against every sphere, for small scenes. id.index names the sphere.
+    virtual bool intersect(const ray& r, double t_min, double t_max, hit_id& id) const override;
+    virtual void materialize(const ray& r, const hit_id& id, hit_record& rec) const override;
+    virtual bool occluded(const ray& r, double t_min, double t_max) const override;
+    virtual bool bounding_box(aabb& output_box) const override;
+
+private:
+    void resize(size_t n);
+
+    size_t count = 0;
+    vector<float> centerX, centerY, centerZ, radius2;
+    vector<uint32_t> materialId;
+    vector<uint32_t> emitterId;     // into emitters, or no_emitter; only read by materialize
+    vector<shared_ptr<const hittable>> emitters;
+    material_table materials;
+};
+
+// BVH over a sphere_set. The spheres are permuted into leaf order so every leaf is one contiguous
+// run handed to the SIMD kernel. Tree is bvh_tree or wide_bvh_tree<N>.
+template<typename Tree>
+class sphere_bvh : public hittable
+{
+public:
+    explicit sphere_bvh(sphere_set set, int maxLeafSize = sphere_set::simd_width);
+    virtual bool intersect(const ray& r, double t_min, double t_max, hit_id& id) const override;
+    virtual void materialize(const ray& r, const hit_id& id, hit_record& rec) const override;
+    virtual bool occluded(const ray& r, double t_min, double t_max) const override;
+    virtual bool bounding_box(aabb& output_box) const override;
+private:
+    Tree tree;
+    sphere_set spheres;
+};
+
+template<typename Tree>
+inline sphere_bvh<Tree>::sphere_bvh(sphere_set set, int maxLeafSize)
+    : spheres(std::move(set))
+{
+    vector<aabb> boxes(spheres.size());
+    for (size_t i = 0; i < boxes.size(); i++)
+        boxes[i] = spheres.sphere_box(static_cast<uint32_t>(i));
+    tree.build(boxes, maxLeafSize, sphere_set::leaf_batch);
+    spheres.permute(tree.order());
+}
+
+template<typename Tree>
+inline bool sphere_bvh<Tree>::intersect(const ray& r, double t_min, double t_max, hit_id& id) const
+{
+    float nearest = static_cast<float>(t_max);
+    uint32_t index = 0;
+    bool found = tree.traverse(r, t_min, t_max, [&](uint32_t first, uint32_t n, double& far) {
+        if (!spheres.intersect_range(r, first, n, static_cast<float>(t_min), nearest, index))
+            return false;
+        far = nearest;
+        return true;
+    });
+    if (found)
+        id = { nearest, &spheres, index };
+    return found;
+}
+
+template<typename Tree>
+inline void sphere_bvh<Tree>::materialize(const ray& r, const hit_id& id, hit_record& rec) const
+{
+    spheres.materialize(r, id, rec);
+}
+
+template<typename Tree>
+inline bool sphere_bvh<Tree>::occluded(const ray& r, double t_min, double t_max) const
+{
+    return tree.template traverse<true>(r, t_min, t_max, [&](uint32_t first, uint32_t n, double& far) {
+        float limit = static_cast<float>(far);
+        uint32_t index;
+        return spheres.intersect_range(r, first, n, static_cast<float>(t_min), limit, index, true);
+    });
+}
+
+template<typename Tree>
+inline bool sphere_bvh<Tree>::bounding_box(aabb& output_box) const
+{
+    output_box = tree.bounds();
+    return !output_box.empty();
+}
+
+// SoA counterpart of make_accelerator: the spheres go into a sphere_bvh in the given layout, or the
+// bare sphere_set (brute force) below brute_force_limit spheres. Other objects of the list are
+// tested by a primitive_set in front of it.
+constexpr size_t brute_force_limit = 16;
+shared_ptr<hittable> make_sphere_accelerator(const hittable_list& list, bvh_layout layout);
+
+#endif
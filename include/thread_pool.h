@@ -0,0 +1,53 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size pool with one task deque per worker. A worker drains its own deque from the front
+// and, once empty, steals from the back of the others, so uneven tiles balance themselves.
+class thread_pool
+{
+public:
+    using task_fn = std::function<void(size_t task, unsigned worker)>;
+
+    explicit thread_pool(unsigned threadCount = 0);
+    ~thread_pool();
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    unsigned size() const { return static_cast<unsigned>(workers.size()); }
+
+    // Runs task(i, worker) for every i in [0, count) and blocks until all of them finished.
+    void parallel_for(size_t count, const task_fn& task);
+
+private:
+    struct task_queue {
+        std::mutex mutex;
+        std::deque<size_t> tasks;
+    };
+
+    void worker_loop(unsigned id);
+    bool pop(unsigned id, size_t& task);
+    bool steal(unsigned id, size_t& task);
+
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<task_queue>> queues;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    std::atomic<const task_fn*> job{ nullptr };
+    uint64_t generation = 0;
+    std::atomic<size_t> remaining{ 0 };
+    bool stopping = false;
+};
+
+#endif
@@ -0,0 +1,269 @@
+#ifndef WIDE_BVH_H
+#define WIDE_BVH_H
+
+#include "bvh.h"
+#include <array>
+#include <string>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define RT_HAVE_SSE 1
+#endif
+#if defined(__AVX__)
+#define RT_HAVE_SSE 1
+#define RT_HAVE_AVX 1
+#endif
+
+// Node of an N-wide BVH with the child boxes stored per axis so one ray can be tested against all
+// of them at once. Unused slots keep an inverted box and never pass the slab test.
+template<int N>
+struct alignas(32) wide_bvh_node {
+    float minX[N], minY[N], minZ[N];
+    float maxX[N], maxY[N], maxZ[N];
+    uint32_t child[N];      // interior: node index, leaf: first primitive
+    uint16_t count[N];      // 0 for interior children and empty slots
+};
+
+// N-wide hierarchy collapsed from a binary bvh_tree. N = 4 uses SSE and N = 8 uses AVX when the
+// compiler targets them; otherwise the slab test falls back to a scalar loop.
+template<int N>
+class wide_bvh_tree
+{
+public:
+    static_assert(N == 4 || N == 8, "wide_bvh_tree supports 4 or 8 children per node");
+
+    void build(const vector<aabb>& boxes, int maxLeafSize = 4, int leafBatch = 1);
+    const vector<uint32_t>& order() const { return binary.order(); }
+    aabb bounds() const { return binary.bounds(); }
+
+    // Same leaf contract as bvh_tree::traverse, AnyHit included.
+    template<bool AnyHit = false, typename LeafFn>
+    bool traverse(const ray& r, double t_min, double t_max, LeafFn&& leaf) const;
+
+private:
+    uint32_t collapse(uint32_t binaryIndex);
+    void set_slot(wide_bvh_node<N>& node, int slot, const linear_bvh_node& child);
+    int intersect(const wide_bvh_node<N>& node, const float orig[3], const float invDir[3],
+        const bool dirIsNeg[3], float t_min, float t_max, float tNear[N]) const;
+
+    bvh_tree binary;
+    vector<wide_bvh_node<N>> nodes;
+};
+
+template<int N>
+inline void wide_bvh_tree<N>::build(const vector<aabb>& boxes, int maxLeafSize, int leafBatch)
+{
+    binary.build(boxes, maxLeafSize, leafBatch);
+    nodes.clear();
+    if (boxes.empty()) return;
+    nodes.reserve(binary.getNodes().size() / 2 + 1);
+    collapse(0);
+}
+
+template<int N>
+inline void wide_bvh_tree<N>::set_slot(wide_bvh_node<N>& node, int slot, const linear_bvh_node& child)
+{
+    node.minX[slot] = child.boundsMin.x;
+    node.minY[slot] = child.boundsMin.y;
+    node.minZ[slot] = child.boundsMin.z;
+    node.maxX[slot] = child.boundsMax.x;
+    node.maxY[slot] = child.boundsMax.y;
+    node.maxZ[slot] = child.boundsMax.z;
+}
+
+template<int N>
+inline uint32_t wide_bvh_tree<N>::collapse(uint32_t binaryIndex)
+{
+    const auto& bin = binary.getNodes();
+    auto index = static_cast<uint32_t>(nodes.size());
+    nodes.emplace_back();
+
+    // open the largest interior child until the node is full
+    std::array<uint32_t, N> kids;
+    int kidCount = 0;
+    if (bin[binaryIndex].primitiveCount > 0)
+    {
+        kids[kidCount++] = binaryIndex;
+    }
+    else
+    {
+        kids[kidCount++] = binaryIndex + 1;
+        kids[kidCount++] = bin[binaryIndex].offset;
+    }
+    while (kidCount < N)
+    {
+        int best = -1;
+        float bestArea = -1.f;
+        for (int i = 0; i < kidCount; i++)
+        {
+            const linear_bvh_node& k = bin[kids[i]];
+            if (k.primitiveCount > 0) continue;
+            float area = aabb(k.boundsMin, k.boundsMax).surface_area();
+            if (area > bestArea)
+            {
+                bestArea = area;
+                best = i;
+            }
+        }
+        if (best < 0) break;
+        uint32_t opened = kids[best];
+        kids[best] = opened + 1;
+        kids[kidCount++] = bin[opened].offset;
+    }
+
+    wide_bvh_node<N> node;
+    for (int slot = 0; slot < N; slot++)
+    {
+        node.minX[slot] = node.minY[slot] = node.minZ[slot] = std::numeric_limits<float>::infinity();
+        node.maxX[slot] = node.maxY[slot] = node.maxZ[slot] = -std::numeric_limits<float>::infinity();
+        node.child[slot] = 0;
+        node.count[slot] = 0;
+    }
+    for (int slot = 0; slot < kidCount; slot++)
+    {
+        const linear_bvh_node& k = bin[kids[slot]];
+        set_slot(node, slot, k);
+        if (k.primitiveCount > 0)
+        {
+            node.child[slot] = k.offset;
+            node.count[slot] = k.primitiveCount;
+        }
+        else
+        {
+            node.child[slot] = collapse(kids[slot]);
+        }
+    }
+    nodes[index] = node;
+    return index;
+}
+
+template<int N>
+inline int wide_bvh_tree<N>::intersect(const wide_bvh_node<N>& node, const float orig[3], const float invDir[3],
+    const bool dirIsNeg[3], float t_min, float t_max, float tNear[N]) const
+{
+    const float* nearX = dirIsNeg[0] ? node.maxX : node.minX;
+    const float* farX = dirIsNeg[0] ? node.minX : node.maxX;
+    const float* nearY = dirIsNeg[1] ? node.maxY : node.minY;
+    const float* farY = dirIsNeg[1] ? node.minY : node.maxY;
+    const float* nearZ = dirIsNeg[2] ? node.maxZ : node.minZ;
+    const float* farZ = dirIsNeg[2] ? node.minZ : node.maxZ;
+#if defined(RT_HAVE_AVX)
+    if constexpr (N == 8)
+    {
+        __m256 ox = _mm256_set1_ps(orig[0]), oy = _mm256_set1_ps(orig[1]), oz = _mm256_set1_ps(orig[2]);
+        __m256 ix = _mm256_set1_ps(invDir[0]), iy = _mm256_set1_ps(invDir[1]), iz = _mm256_set1_ps(invDir[2]);
+        __m256 t0 = _mm256_max_ps(_mm256_set1_ps(t_min), _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(nearX), ox), ix));
+        t0 = _mm256_max_ps(t0, _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(nearY), oy), iy));
+        t0 = _mm256_max_ps(t0, _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(nearZ), oz), iz));
+        __m256 t1 = _mm256_min_ps(_mm256_set1_ps(t_max), _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(farX), ox), ix));
+        t1 = _mm256_min_ps(t1, _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(farY), oy), iy));
+        t1 = _mm256_min_ps(t1, _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(farZ), oz), iz));
+        _mm256_storeu_ps(tNear, t0);
+        return _mm256_movemask_ps(_mm256_cmp_ps(t0, t1, _CMP_LE_OQ));
+    }
+#endif
+#if defined(RT_HAVE_SSE)
+    if constexpr (N == 4)
+    {
+        __m128 ox = _mm_set1_ps(orig[0]), oy = _mm_set1_ps(orig[1]), oz = _mm_set1_ps(orig[2]);
+        __m128 ix = _mm_set1_ps(invDir[0]), iy = _mm_set1_ps(invDir[1]), iz = _mm_set1_ps(invDir[2]);
+        __m128 t0 = _mm_max_ps(_mm_set1_ps(t_min), _mm_mul_ps(_mm_sub_ps(_mm_load_ps(nearX), ox), ix));
+        t0 = _mm_max_ps(t0, _mm_mul_ps(_mm_sub_ps(_mm_load_ps(nearY), oy), iy));
+        t0 = _mm_max_ps(t0, _mm_mul_ps(_mm_sub_ps(_mm_load_ps(nearZ), oz), iz));
+        __m128 t1 = _mm_min_ps(_mm_set1_ps(t_max), _mm_mul_ps(_mm_sub_ps(_mm_load_ps(farX), ox), ix));
+        t1 = _mm_min_ps(t1, _mm_mul_ps(_mm_sub_ps(_mm_load_ps(farY), oy), iy));
+        t1 = _mm_min_ps(t1, _mm_mul_ps(_mm_sub_ps(_mm_load_ps(farZ), oz), iz));
+        _mm_storeu_ps(tNear, t0);
+        return _mm_movemask_ps(_mm_cmple_ps(t0, t1));
+    }
+#endif
+    int mask = 0;
+    for (int i = 0; i < N; i++)
+    {
+        float t0 = std::max(t_min, (nearX[i] - orig[0]) * invDir[0]);
+        t0 = std::max(t0, (nearY[i] - orig[1]) * invDir[1]);
+        t0 = std::max(t0, (nearZ[i] - orig[2]) * invDir[2]);
+        float t1 = std::min(t_max, (farX[i] - orig[0]) * invDir[0]);
+        t1 = std::min(t1, (farY[i] - orig[1]) * invDir[1]);
+        t1 = std::min(t1, (farZ[i] - orig[2]) * invDir[2]);
+        tNear[i] = t0;
+        if (t0 <= t1) mask |= 1 << i;
+    }
+    return mask;
+}
+
+template<int N>
+template<bool AnyHit, typename LeafFn>
+inline bool wide_bvh_tree<N>::traverse(const ray& r, double t_min, double t_max, LeafFn&& leaf) const
+{
+    if (nodes.empty()) return false;
+    const glm::vec3 o = r.origin();
+    const glm::vec3 d = r.direction();
+    const float orig[3] = { o.x, o.y, o.z };
+    const float invDir[3] = { 1.f / d.x, 1.f / d.y, 1.f / d.z };
+    const bool dirIsNeg[3] = { invDir[0] < 0, invDir[1] < 0, invDir[2] < 0 };
+
+    struct entry {
+        uint32_t child;
+        uint32_t count;
+        float tNear;
+    };
+    entry stack[bvh_tree::max_depth * N];
+    int stackSize = 0;
+    stack[stackSize++] = { 0, 0, static_cast<float>(t_min) };
+    uint64_t visited = 0;
+    bool hitAnything = false;
+    while (stackSize > 0)
+    {
+        entry e = stack[--stackSize];
+        if (e.tNear > t_max) continue;
+        if (e.count > 0)
+        {
+            if (leaf(e.child, e.count, t_max))
+            {
+                hitAnything = true;
+                if constexpr (AnyHit) break;
+            }
+            continue;
+        }
+
+        const wide_bvh_node<N>& node = nodes[e.child];
+        visited++;
+        alignas(32) float tNear[N];
+        int mask = intersect(node, orig, invDir, dirIsNeg, static_cast<float>(t_min), static_cast<float>(t_max), tNear);
+
+        // push hit children far to near so the closest one is popped first
+        int base = stackSize;
+        for (int i = 0; i < N; i++)
+        {
+            if (!(mask & (1 << i))) continue;
+            entry child = { node.child[i], node.count[i], tNear[i] };
+            int j = stackSize++;
+            while (j > base && stack[j - 1].tNear < child.tNear)
+            {
+                stack[j] = stack[j - 1];
+                j--;
+            }
+            stack[j] = child;
+        }
+    }
+    auto& stats = thread_traversal_stats();
+    stats.rays++;
+    stats.nodesVisited += visited;
+    return hitAnything;
+}
+
+template<int N>
+using wide_bvh = bvh_accelerator<wide_bvh_tree<N>>;
+
+using bvh4 = wide_bvh<4>;
+using bvh8 = wide_bvh<8>;
+
+enum class bvh_layout { binary, bvh4, bvh8 };
+
+bool parse_bvh_layout(const std::string& name, bvh_layout& layout);
+shared_ptr<hittable> make_accelerator(const hittable_list& list, bvh_layout layout);
+
+#endif
@@ -0,0 +1,149 @@
+#include "bvh.h"
+
+namespace sah
+{
+    split partition(const vector<aabb>& boxes, vector<uint32_t>& order, size_t begin, size_t end)
+    {
+        split best;
+        aabb centroidBounds;
+        for (size_t i = begin; i < end; i++)
+            centroidBounds.expand(boxes[order[i]].centroid());
+
+        glm::vec3 extent = centroidBounds.max() - centroidBounds.min();
+        int bestBin = -1;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            if (extent[axis] <= 0.f) continue;
+            float scale = bin_count / extent[axis];
+            auto binOf = [&](uint32_t prim) {
+                int b = static_cast<int>((boxes[prim].centroid()[axis] - centroidBounds.min()[axis]) * scale);
+                return std::min(b, bin_count - 1);
+            };
+
+            aabb binBoxes[bin_count];
+            size_t binCounts[bin_count] = {};
+            for (size_t i = begin; i < end; i++)
+            {
+                int b = binOf(order[i]);
+                binCounts[b]++;
+                binBoxes[b].expand(boxes[order[i]]);
+            }
+
+            // sweep from the right to collect suffix areas, then from the left to evaluate each plane
+            float rightArea[bin_count];
+            size_t rightCount[bin_count];
+            aabb acc;
+            size_t count = 0;
+            for (int b = bin_count - 1; b > 0; b--)
+            {
+                acc.expand(binBoxes[b]);
+                count += binCounts[b];
+                rightArea[b] = acc.surface_area();
+                rightCount[b] = count;
+            }
+            acc = aabb();
+            count = 0;
+            for (int b = 1; b < bin_count; b++)
+            {
+                acc.expand(binBoxes[b - 1]);
+                count += binCounts[b - 1];
+                if (count == 0 || rightCount[b] == 0) continue;
+                float cost = acc.surface_area() * count + rightArea[b] * rightCount[b];
+                if (cost < best.cost)
+                {
+                    best.cost = cost;
+                    best.axis = axis;
+                    bestBin = b;
+                }
+            }
+        }
+
+        if (best.axis >= 0)
+        {
+            int axis = best.axis;
+            float scale = bin_count / extent[axis];
+            float lo = centroidBounds.min()[axis];
+            auto it = std::partition(order.begin() + begin, order.begin() + end, [&](uint32_t prim) {
+                int b = static_cast<int>((boxes[prim].centroid()[axis] - lo) * scale);
+                return std::min(b, bin_count - 1) < bestBin;
+            });
+            best.mid = static_cast<size_t>(it - order.begin());
+            aabb bounds;
+            for (size_t i = begin; i < end; i++) bounds.expand(boxes[order[i]]);
+            best.cost = traversal_cost + intersection_cost * best.cost / bounds.surface_area();
+            if (best.mid != begin && best.mid != end) return best;
+        }
+
+        if (extent.x <= 0.f && extent.y <= 0.f && extent.z <= 0.f)
+        {
+            best.axis = -1;
+            best.mid = begin + (end - begin) / 2;
+            return best;
+        }
+
+        best.axis = centroidBounds.longest_axis();
+        best.mid = begin + (end - begin) / 2;
+        int axis = best.axis;
+        std::nth_element(order.begin() + begin, order.begin() + best.mid, order.begin() + end,
+            [&](uint32_t a, uint32_t b) { return boxes[a].centroid()[axis] < boxes[b].centroid()[axis]; });
+        return best;
+    }
+}
+
+void bvh_tree::build(const vector<aabb>& boxes, int maxLeafSize, int batch)
+{
+    nodes.clear();
+    primitiveOrder.resize(boxes.size());
+    for (size_t i = 0; i < boxes.size(); i++)
+        primitiveOrder[i] = static_cast<uint32_t>(i);
+    leafSize = maxLeafSize;
+    leafBatch = std::max(batch, 1);
+    if (boxes.empty()) return;
+    nodes.reserve(2 * boxes.size());
+    build_recursive(boxes, 0, boxes.size(), 0);
+}
+
+uint32_t bvh_tree::build_recursive(const vector<aabb>& boxes, size_t begin, size_t end, int depth)
+{
+    auto index = static_cast<uint32_t>(nodes.size());
+    nodes.emplace_back();
+    aabb bounds;
+    for (size_t i = begin; i < end; i++)
+        bounds.expand(boxes[primitiveOrder[i]]);
+
+    size_t count = end - begin;
+    auto makeLeaf = [&]() {
+        if (count > std::numeric_limits<uint16_t>::max())
+            throw std::length_error("bvh_tree: leaf too large");
+        linear_bvh_node& node = nodes[index];
+        node.boundsMin = bounds.min();
+        node.boundsMax = bounds.max();
+        node.offset = static_cast<uint32_t>(begin);
+        node.primitiveCount = static_cast<uint16_t>(count);
+        node.axis = 0;
+        return index;
+    };
+
+    if (count == 1 || depth >= max_depth - 1)
+        return makeLeaf();
+    auto split = sah::partition(boxes, primitiveOrder, begin, end);
+    float leafCost = sah::intersection_cost * ((count + leafBatch - 1) / leafBatch);
+    if (count <= static_cast<size_t>(leafSize) && (split.axis < 0 || split.cost >= leafCost))
+        return makeLeaf();
+
+    build_recursive(boxes, begin, split.mid, depth + 1);
+    uint32_t second = build_recursive(boxes, split.mid, end, depth + 1);
+    linear_bvh_node& node = nodes[index];
+    node.boundsMin = bounds.min();
+    node.boundsMax = bounds.max();
+    node.offset = second;
+    node.primitiveCount = 0;
+    node.axis = static_cast<uint8_t>(split.axis < 0 ? bounds.longest_axis() : split.axis);
+    return index;
+}
+
+aabb bvh_tree::bounds() const
+{
+    if (nodes.empty()) return aabb();
+    return aabb(nodes[0].boundsMin, nodes[0].boundsMax);
+}
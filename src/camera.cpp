@@ -0,0 +1,38 @@
+#include "camera.h"
+
+vec3 camera::getLLCL()
+{
+	return vec3(-screenWidth / 2, .0f, .0f) + vec3(.0f, -screenHeight / 2, .0f) + vec3(.0f, .0f, -focalLength);
+}
+
+void camera::setEye(const vec3& e)
+{
+	eye = e;
+	updateCamera();
+}
+
+void camera::setCenter(const vec3& c)
+{
+	center = c;
+	updateCamera();
+}
+
+void camera::updateCamera()
+{
+	viewToWorld = inverse(lookAt(eye, center, up));
+	lowerLeftCornerLocal = getLLCL();
+}
+
+ray camera::getRayFromScreenPos(double u, double v, rtweekend::sampler&) const
+{
+	auto pixelPosLocal = lowerLeftCornerLocal + vec3(0.f, u * screenHeight, 0.f) + vec3(v * screenWidth, 0.f, 0.f);
+	return ray(eye, vec3(viewToWorld * vec4(pixelPosLocal, 1.0f))-eye);
+}
+
+ray blurcamera::getRayFromScreenPos(double u, double v, rtweekend::sampler& rng) const
+{
+	vec3 rd = static_cast<float>(lensRadius) * rtweekend::random_in_unit_disk(rng);
+	vec3 offset = vec3(rd.x * u, rd.y * v, 0.f);
+	auto pixelPosLocal = lowerLeftCornerLocal + vec3(0.f, u * screenHeight, 0.f) + vec3(v * screenWidth, 0.f, 0.f);
+	return ray(eye + offset, vec3(viewToWorld * vec4(pixelPosLocal, 1.0f)) - eye - offset);
+}
@@ -0,0 +1,82 @@
+#include "hittable.h"
+#include "material.h"
+
+sphere::sphere(const glm::vec3& c, double r, shared_ptr<material> pm)
+		: center(c), radius(r), pMat(pm) {}
+
+bool sphere::intersect(const ray& r, double t_min, double t_max, hit_id& id) const
+{
+    double root;
+    if (!intersect_sphere(center, radius, r, t_min, t_max, root))
+        return false;
+    id.t = root;
+    id.prim = this;
+    id.index = 0;
+    return true;
+}
+
+void sphere::materialize(const ray& r, const hit_id& id, hit_record& rec) const
+{
+    rec.t = id.t;
+    rec.p = r.at(id.t);
+    glm::vec3 outward_normal = (rec.p - center) / static_cast<float>(radius);
+    rec.set_face_normal(r, outward_normal);
+    rec.pMat = &pMat->getRecord();
+    rec.emitter = this;
+}
+
+bool sphere::occluded(const ray& r, double t_min, double t_max) const
+{
+    double root;
+    return intersect_sphere(center, radius, r, t_min, t_max, root);
+}
+
+bool sphere::bounding_box(aabb& output_box) const
+{
+    auto extent = glm::vec3(static_cast<float>(radius));
+    output_box = aabb(center - extent, center + extent);
+    return true;
+}
+
+bool hittable_list::intersect(const ray& r, double t_min, double t_max, hit_id& id) const
+{
+    bool hitAnything = false;
+    double far = t_max;
+	for(const auto& obj : objects)
+	{
+		if(obj->intersect(r, t_min, far, id))
+		{
+            hitAnything = true;
+            far = id.t;
+		}
+	}
+    return hitAnything;
+}
+
+void hittable_list::materialize(const ray& r, const hit_id& id, hit_record& rec) const
+{
+    id.prim->materialize(r, id, rec);
+}
+
+bool hittable_list::occluded(const ray& r, double t_min, double t_max) const
+{
+    for (const auto& obj : objects)
+    {
+        if (obj->occluded(r, t_min, t_max))
+            return true;
+    }
+    return false;
+}
+
+bool hittable_list::bounding_box(aabb& output_box) const
+{
+    if (objects.empty()) return false;
+    aabb tempBox;
+    output_box = aabb();
+    for (const auto& obj : objects)
+    {
+        if (!obj->bounding_box(tempBox)) return false;
+        output_box.expand(tempBox);
+    }
+    return true;
+}
@@ -0,0 +1,150 @@
+#include "image_io.h"
+
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+
+namespace image_io
+{
+    std::vector<unsigned char> to_rgb8(int width, int height, const std::vector<glm::vec3>& image)
+    {
+        std::vector<unsigned char> bytes(static_cast<size_t>(width) * height * 3);
+        size_t index = 0;
+        for (int j = height - 1; j >= 0; --j) {
+            for (int i = 0; i < width; ++i) {
+                const glm::vec3& c = image[static_cast<size_t>(j) * width + i];
+                bytes[index++] = encode_gamma(c.r);
+                bytes[index++] = encode_gamma(c.g);
+                bytes[index++] = encode_gamma(c.b);
+            }
+        }
+        return bytes;
+    }
+
+    bool write_ppm(const std::string& path, int width, int height, const std::vector<glm::vec3>& image)
+    {
+        std::ofstream out(path, std::ios::binary);
+        if (!out) return false;
+        auto bytes = to_rgb8(width, height, image);
+        out << "P6\n" << width << " " << height << "\n255\n";
+        out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        return static_cast<bool>(out);
+    }
+
+    bool write_pfm(const std::string& path, int width, int height, const std::vector<glm::vec3>& image)
+    {
+        std::ofstream out(path, std::ios::binary);
+        if (!out) return false;
+        // negative scale marks little-endian data; PFM rows run bottom to top like ours
+        out << "PF\n" << width << " " << height << "\n-1.0\n";
+        const uint16_t probe = 1;
+        const bool littleEndian = *reinterpret_cast<const unsigned char*>(&probe) == 1;
+        for (size_t p = 0; p < static_cast<size_t>(width) * height; p++) {
+            float rgb[3] = { image[p].r, image[p].g, image[p].b };
+            for (float f : rgb) {
+                unsigned char b[4];
+                std::memcpy(b, &f, 4);
+                if (!littleEndian) std::reverse(b, b + 4);
+                out.write(reinterpret_cast<const char*>(b), 4);
+            }
+        }
+        return static_cast<bool>(out);
+    }
+
+    namespace detail
+    {
+        uint32_t crc32(const unsigned char* data, size_t size, uint32_t crc = 0)
+        {
+            static const auto table = [] {
+                std::vector<uint32_t> t(256);
+                for (uint32_t n = 0; n < 256; n++) {
+                    uint32_t c = n;
+                    for (int k = 0; k < 8; k++)
+                        c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+                    t[n] = c;
+                }
+                return t;
+            }();
+            crc = ~crc;
+            for (size_t i = 0; i < size; i++)
+                crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+            return ~crc;
+        }
+
+        void put_u32(std::vector<unsigned char>& v, uint32_t x)
+        {
+            v.push_back(static_cast<unsigned char>(x >> 24));
+            v.push_back(static_cast<unsigned char>(x >> 16));
+            v.push_back(static_cast<unsigned char>(x >> 8));
+            v.push_back(static_cast<unsigned char>(x));
+        }
+
+        void write_chunk(std::ofstream& out, const char* type, const std::vector<unsigned char>& payload)
+        {
+            std::vector<unsigned char> chunk;
+            put_u32(chunk, static_cast<uint32_t>(payload.size()));
+            chunk.insert(chunk.end(), type, type + 4);
+            chunk.insert(chunk.end(), payload.begin(), payload.end());
+            put_u32(chunk, crc32(chunk.data() + 4, chunk.size() - 4));
+            out.write(reinterpret_cast<const char*>(chunk.data()), static_cast<std::streamsize>(chunk.size()));
+        }
+    }
+
+    bool write_png(const std::string& path, int width, int height, const std::vector<glm::vec3>& image)
+    {
+        std::ofstream out(path, std::ios::binary);
+        if (!out) return false;
+        auto bytes = to_rgb8(width, height, image);
+
+        std::vector<unsigned char> raw;
+        const size_t stride = static_cast<size_t>(width) * 3;
+        raw.reserve((stride + 1) * height);
+        for (int y = 0; y < height; y++) {
+            raw.push_back(0); // filter: none
+            raw.insert(raw.end(), bytes.begin() + y * stride, bytes.begin() + (y + 1) * stride);
+        }
+
+        std::vector<unsigned char> zlib = { 0x78, 0x01 };
+        uint32_t a = 1, b = 0;
+        for (unsigned char c : raw) {
+            a = (a + c) % 65521;
+            b = (b + a) % 65521;
+        }
+        size_t pos = 0;
+        do {
+            size_t len = std::min<size_t>(65535, raw.size() - pos);
+            zlib.push_back(pos + len == raw.size() ? 1 : 0);
+            zlib.push_back(static_cast<unsigned char>(len));
+            zlib.push_back(static_cast<unsigned char>(len >> 8));
+            zlib.push_back(static_cast<unsigned char>(~len));
+            zlib.push_back(static_cast<unsigned char>(~len >> 8));
+            zlib.insert(zlib.end(), raw.begin() + pos, raw.begin() + pos + len);
+            pos += len;
+        } while (pos < raw.size());
+        detail::put_u32(zlib, (b << 16) | a);
+
+        std::vector<unsigned char> header;
+        detail::put_u32(header, static_cast<uint32_t>(width));
+        detail::put_u32(header, static_cast<uint32_t>(height));
+        header.insert(header.end(), { 8, 2, 0, 0, 0 }); // 8-bit RGB, no interlace
+
+        const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+        out.write(reinterpret_cast<const char*>(signature), 8);
+        detail::write_chunk(out, "IHDR", header);
+        detail::write_chunk(out, "IDAT", zlib);
+        detail::write_chunk(out, "IEND", {});
+        return static_cast<bool>(out);
+    }
+
+    bool write_image(const std::string& path, int width, int height, const std::vector<glm::vec3>& image)
+    {
+        auto dot = path.find_last_of('.');
+        std::string ext = dot == std::string::npos ? "" : path.substr(dot + 1);
+        std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        if (ext == "png") return write_png(path, width, height, image);
+        if (ext == "pfm") return write_pfm(path, width, height, image);
+        if (ext == "ppm") return write_ppm(path, width, height, image);
+        return false;
+    }
+}
@@ -0,0 +1,89 @@
+#include "light.h"
+#include "material.h"
+#include <algorithm>
+#include <cmath>
+
+// depth-first, so the lights keep the order the scene lists them in
+static void collect_lights(const hittable_list& list, std::vector<shared_ptr<const sphere>>& found)
+{
+    for (const auto& obj : list.getObjects())
+    {
+        if (auto nested = std::dynamic_pointer_cast<hittable_list>(obj)) {
+            collect_lights(*nested, found);
+            continue;
+        }
+        auto s = std::dynamic_pointer_cast<sphere>(obj);
+        if (s && s->pMat->getRecord().type == material_type::diffuse_light
+            && std::find(found.begin(), found.end(), s) == found.end())
+            found.push_back(s);
+    }
+}
+
+light_list::light_list(const hittable_list& scene)
+{
+    std::vector<shared_ptr<const sphere>> found;
+    collect_lights(scene, found);
+    for (auto& s : found)
+        add(std::move(s));
+}
+
+void light_list::add(shared_ptr<const sphere> s)
+{
+    lights.push_back({ s->center, static_cast<float>(s->radius), s->pMat->getRecord().albedo });
+    sources.push_back(std::move(s));
+}
+
+// 1 - cos(theta_max) of the cone a light subtends from p, written so it keeps its precision for
+// small, distant lights; false when p lies inside the light
+static bool cone_extent(const sphere_light& light, const glm::vec3& p, float& oneMinusCosMax)
+{
+    glm::vec3 toCenter = light.center - p;
+    float dist2 = glm::dot(toCenter, toCenter);
+    float radius2 = light.radius * light.radius;
+    if (dist2 <= radius2)
+        return false;
+    float sin2Max = radius2 / dist2;
+    oneMinusCosMax = sin2Max / (1.f + std::sqrt(1.f - sin2Max));
+    return true;
+}
+
+bool light_list::sample(const glm::vec3& p, rtweekend::sampler& rng, light_sample& s) const
+{
+    rng.seek(rtweekend::sampler::dim_light_select);
+    size_t index = std::min(static_cast<size_t>(rng.next_double() * lights.size()), lights.size() - 1);
+    const sphere_light& light = lights[index];
+
+    float oneMinusCosMax;
+    if (!cone_extent(light, p, oneMinusCosMax))
+        return false;
+
+    glm::vec3 toCenter = light.center - p;
+    float dist2 = glm::dot(toCenter, toCenter);
+    float radius2 = light.radius * light.radius;
+    rng.seek(rtweekend::sampler::dim_light);
+    float cosTheta = 1.f - static_cast<float>(rng.next_double()) * oneMinusCosMax;
+    float sinTheta = std::sqrt(std::fmax(0.f, 1.f - cosTheta * cosTheta));
+    float phi = static_cast<float>(2 * rtweekend::pi * rng.next_double());
+    float dist = std::sqrt(dist2);
+    glm::vec3 axis = toCenter / dist;
+    s.direction = rtweekend::onb(axis).local(glm::vec3(sinTheta * std::cos(phi), sinTheta * std::sin(phi), cosTheta));
+
+    // nearer root of the ray-sphere quadratic; the discriminant only dips below 0 by rounding
+    float b = dist * cosTheta;
+    float disc = radius2 - (dist2 - b * b);
+    s.distance = b - std::sqrt(std::fmax(disc, 0.f));
+    s.radiance = light.radiance;
+    s.pdf = 1.f / (static_cast<float>(2 * rtweekend::pi) * oneMinusCosMax * lights.size());
+    return true;
+}
+
+float light_list::pdf(const hittable* emitter, const glm::vec3& p) const
+{
+    size_t light = 0;
+    while (light < sources.size() && sources[light].get() != emitter)
+        light++;
+    float oneMinusCosMax;
+    if (light == sources.size() || !cone_extent(lights[light], p, oneMinusCosMax))
+        return 0.f;
+    return 1.f / (static_cast<float>(2 * rtweekend::pi) * oneMinusCosMax * lights.size());
+}
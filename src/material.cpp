@@ -0,0 +1,106 @@
+#include "material.h"
+
+lambertian::lambertian(const vec3& color): material(material_type::lambertian, color, 0.f) {}
+
+metal::metal(const vec3& color) : material(material_type::metal, color, 0.f) {}
+
+metal::metal(material_type type, const vec3& color, float param) : material(type, color, param) {}
+
+FuzzyMetal::FuzzyMetal(const vec3& color, double f)
+	: metal(f > 0 ? material_type::fuzzy_metal : material_type::metal, color, f > 0 ? static_cast<float>(5 / (f * f)) : 0.f) {}
+
+static float phong_pdf(float exponent, const vec3& mirror, const vec3& direction)
+{
+	float cosAlpha = dot(mirror, direction);
+	if (cosAlpha <= 0.f) return 0.f;
+	return (exponent + 1) / static_cast<float>(2 * rtweekend::pi) * std::pow(cosAlpha, exponent);
+}
+
+bool scatter(const material_record& mat, const ray& rIn, const hit_record& record, vec3& attenuation, ray& scattered, rtweekend::sampler& rng)
+{
+	switch (mat.type)
+	{
+	case material_type::lambertian:
+	{
+		// cosine-weighted sampling cancels the cos(theta) / pi of the Lambertian BRDF, so the
+		// throughput is just the albedo
+		vec3 scatteredDirection = rtweekend::onb(record.normal).local(rtweekend::random_cosine_direction(rng));
+		scattered = ray(record.p, scatteredDirection);
+		attenuation = mat.albedo;
+		return true;
+	}
+	case material_type::metal:
+	{
+		vec3 scatteredDirection = rtweekend::reflect(glm::normalize(rIn.direction()), record.normal);
+		scattered = ray(record.p, scatteredDirection);
+		attenuation = mat.albedo;
+		return true;
+	}
+	case material_type::fuzzy_metal:
+	{
+		// cos(alpha) = u^(1 / (n + 1)) samples the lobe around the mirror direction exactly
+		vec3 mirror = rtweekend::reflect(glm::normalize(rIn.direction()), record.normal);
+		float cosAlpha = std::pow(static_cast<float>(rng.next_double()), 1.f / (mat.param + 1));
+		float sinAlpha = std::sqrt(std::fmax(0.f, 1.f - cosAlpha * cosAlpha));
+		float phi = static_cast<float>(2 * rtweekend::pi * rng.next_double());
+		vec3 scatteredDirection = rtweekend::onb(mirror).local(vec3(sinAlpha * std::cos(phi), sinAlpha * std::sin(phi), cosAlpha));
+		scattered = ray(record.p, scatteredDirection);
+		attenuation = mat.albedo;
+		// lobe directions below the surface are absorbed
+		return dot(scatteredDirection, record.normal) > 0;
+	}
+	case material_type::dielectric:
+	{
+		attenuation = mat.albedo;
+		float ir = mat.param;
+		float refraction_ratio = record.front_face ? (1.0 / ir) : ir;
+		vec3 unit_direction = normalize(rIn.direction());
+		float cos_theta = fmin(dot(-unit_direction, record.normal), 1.0);
+		float sin_theta = sqrt(1.0 - cos_theta * cos_theta);
+		bool cannot_refract = refraction_ratio * sin_theta > 1.0;
+		vec3 direction;
+		if (cannot_refract) { direction = rtweekend::reflect(unit_direction, record.normal); }
+		else { direction = rtweekend::refract(unit_direction, record.normal, refraction_ratio); }
+		scattered = ray(record.p, direction);
+		return true;
+	}
+	case material_type::diffuse_light:
+		return false;
+	}
+	return false;
+}
+
+float pdf(const material_record& mat, const ray& rIn, const hit_record& record, const vec3& direction)
+{
+	switch (mat.type)
+	{
+	case material_type::lambertian:
+		return std::fmax(dot(direction, record.normal), 0.f) / static_cast<float>(rtweekend::pi);
+	case material_type::fuzzy_metal:
+	{
+		if (dot(direction, record.normal) <= 0.f) return 0.f;
+		vec3 mirror = rtweekend::reflect(glm::normalize(rIn.direction()), record.normal);
+		return phong_pdf(mat.param, mirror, direction);
+	}
+	default:
+		return 0.f;
+	}
+}
+
+vec3 evaluate(const material_record& mat, const ray& rIn, const hit_record& record, const vec3& direction)
+{
+	// both lobes are sampled in proportion to BSDF * cos, which leaves albedo * pdf
+	return mat.albedo * pdf(mat, rIn, record, direction);
+}
+
+uint32_t material_table::add(const shared_ptr<material>& mat)
+{
+	auto found = index.find(mat.get());
+	if (found != index.end())
+		return found->second;
+	auto id = static_cast<uint32_t>(records.size());
+	index.emplace(mat.get(), id);
+	records.push_back(mat->getRecord());
+	owners.push_back(mat);
+	return id;
+}
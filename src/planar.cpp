@@ -0,0 +1,118 @@
+#include "planar.h"
+#include "material.h"
+
+// flat boxes get a little thickness so the slab test never sees a zero-width interval
+static aabb padded(aabb box)
+{
+    const glm::vec3 pad(1e-4f);
+    return aabb(box.min() - pad, box.max() + pad);
+}
+
+aabb disk_shape::box() const
+{
+    // per axis the disk extends radius * sqrt(1 - n_i^2) around its center
+    const glm::vec3 n = support.normal;
+    glm::vec3 extent = std::sqrt(radius2) * glm::sqrt(glm::max(glm::vec3(1.f) - n * n, glm::vec3(0.f)));
+    return padded(aabb(center - extent, center + extent));
+}
+
+aabb quad_shape::box() const
+{
+    aabb box;
+    box.expand(corner);
+    box.expand(corner + u);
+    box.expand(corner + v);
+    box.expand(corner + u + v);
+    return padded(box);
+}
+
+plane_shape make_plane_shape(const glm::vec3& point, const glm::vec3& normal)
+{
+    glm::vec3 n = glm::normalize(normal);
+    return { n, glm::dot(n, point) };
+}
+
+disk_shape make_disk_shape(const glm::vec3& center, const glm::vec3& normal, float radius)
+{
+    return { make_plane_shape(center, normal), center, radius * radius };
+}
+
+quad_shape make_quad_shape(const glm::vec3& corner, const glm::vec3& u, const glm::vec3& v)
+{
+    glm::vec3 n = glm::cross(u, v);
+    return { make_plane_shape(corner, n), corner, u, v, n / glm::dot(n, n) };
+}
+
+static void materialize_flat(const ray& r, const hit_id& id, const glm::vec3& normal, const material& mat, hit_record& rec)
+{
+    rec.t = id.t;
+    rec.p = r.at(id.t);
+    rec.set_face_normal(r, normal);
+    rec.pMat = &mat.getRecord();
+    rec.emitter = nullptr;
+}
+
+plane::plane(const glm::vec3& point, const glm::vec3& normal, shared_ptr<material> m)
+    : shape(make_plane_shape(point, normal)), pMat(m) {}
+
+bool plane::intersect(const ray& r, double t_min, double t_max, hit_id& id) const
+{
+    double t;
+    if (!shape.intersect(r, t_min, t_max, t)) return false;
+    id = { t, this, 0 };
+    return true;
+}
+
+void plane::materialize(const ray& r, const hit_id& id, hit_record& rec) const
+{
+    materialize_flat(r, id, shape.normal, *pMat, rec);
+}
+
+bool plane::bounding_box(aabb&) const
+{
+    return false;
+}
+
+disk::disk(const glm::vec3& center, const glm::vec3& normal, float radius, shared_ptr<material> m)
+    : shape(make_disk_shape(center, normal, radius)), pMat(m) {}
+
+bool disk::intersect(const ray& r, double t_min, double t_max, hit_id& id) const
+{
+    double t;
+    if (!shape.intersect(r, t_min, t_max, t)) return false;
+    id = { t, this, 0 };
+    return true;
+}
+
+void disk::materialize(const ray& r, const hit_id& id, hit_record& rec) const
+{
+    materialize_flat(r, id, shape.support.normal, *pMat, rec);
+}
+
+bool disk::bounding_box(aabb& output_box) const
+{
+    output_box = shape.box();
+    return true;
+}
+
+quad::quad(const glm::vec3& corner, const glm::vec3& u, const glm::vec3& v, shared_ptr<material> m)
+    : shape(make_quad_shape(corner, u, v)), pMat(m) {}
+
+bool quad::intersect(const ray& r, double t_min, double t_max, hit_id& id) const
+{
+    double t;
+    if (!shape.intersect(r, t_min, t_max, t)) return false;
+    id = { t, this, 0 };
+    return true;
+}
+
+void quad::materialize(const ray& r, const hit_id& id, hit_record& rec) const
+{
+    materialize_flat(r, id, shape.support.normal, *pMat, rec);
+}
+
+bool quad::bounding_box(aabb& output_box) const
+{
+    output_box = shape.box();
+    return true;
+}
@@ -0,0 +1,239 @@
+#include "primitive_set.h"
+#include <stdexcept>
+
+primitive_set::primitive_set(const hittable_list& list)
+{
+    for (const auto& obj : list.getObjects())
+    {
+        if (auto s = std::dynamic_pointer_cast<sphere>(obj))
+            add(*s, s);
+        else if (auto p = std::dynamic_pointer_cast<plane>(obj))
+            add(*p);
+        else if (auto d = std::dynamic_pointer_cast<disk>(obj))
+            add(*d);
+        else if (auto q = std::dynamic_pointer_cast<quad>(obj))
+            add(*q);
+        else
+            add_custom(obj);
+    }
+}
+
+void primitive_set::add(const sphere& s, shared_ptr<const hittable> source)
+{
+    uint32_t emitter = no_emitter;
+    if (source && s.pMat->getRecord().type == material_type::diffuse_light) {
+        emitter = static_cast<uint32_t>(emitters.size());
+        emitters.push_back(std::move(source));
+    }
+    refs.push_back({ primitive_type::sphere, static_cast<uint32_t>(spheres.size()) });
+    spheres.push_back({ s.center, s.radius, materials.add(s.pMat), emitter });
+}
+
+void primitive_set::add(const plane& p)
+{
+    refs.push_back({ primitive_type::plane, static_cast<uint32_t>(planes.size()) });
+    planes.push_back({ p.shape, materials.add(p.pMat) });
+}
+
+void primitive_set::add(const disk& d)
+{
+    refs.push_back({ primitive_type::disk, static_cast<uint32_t>(disks.size()) });
+    disks.push_back({ d.shape, materials.add(d.pMat) });
+}
+
+void primitive_set::add(const quad& q)
+{
+    refs.push_back({ primitive_type::quad, static_cast<uint32_t>(quads.size()) });
+    quads.push_back({ q.shape, materials.add(q.pMat) });
+}
+
+void primitive_set::add_custom(shared_ptr<hittable> obj)
+{
+    refs.push_back({ primitive_type::custom, static_cast<uint32_t>(custom.size()) });
+    custom.push_back(obj);
+}
+
+bool primitive_set::primitive_box(uint32_t i, aabb& box) const
+{
+    const primitive_ref& ref = refs[i];
+    switch (ref.type)
+    {
+    case primitive_type::sphere:
+    {
+        const sphere_primitive& s = spheres[ref.index];
+        auto extent = glm::vec3(static_cast<float>(s.radius));
+        box = aabb(s.center - extent, s.center + extent);
+        return true;
+    }
+    case primitive_type::plane:
+        return false;
+    case primitive_type::disk:
+        box = disks[ref.index].shape.box();
+        return true;
+    case primitive_type::quad:
+        box = quads[ref.index].shape.box();
+        return true;
+    default:
+        return custom[ref.index]->bounding_box(box);
+    }
+}
+
+vector<aabb> primitive_set::bounded_boxes()
+{
+    vector<aabb> boxes;
+    vector<uint32_t> order, unbounded;
+    boxes.reserve(refs.size());
+    order.reserve(refs.size());
+    for (uint32_t i = 0; i < refs.size(); i++)
+    {
+        aabb box;
+        if (primitive_box(i, box)) {
+            boxes.push_back(box);
+            order.push_back(i);
+        }
+        else {
+            unbounded.push_back(i);
+        }
+    }
+    order.insert(order.end(), unbounded.begin(), unbounded.end());
+    permute(order);
+    boundedCount = boxes.size();
+    return boxes;
+}
+
+template<typename T>
+static void append_reordered(vector<T>& sorted, const vector<T>& source, uint32_t& index)
+{
+    sorted.push_back(source[index]);
+    index = static_cast<uint32_t>(sorted.size() - 1);
+}
+
+void primitive_set::permute(const vector<uint32_t>& order)
+{
+    // rebuild the per-type arrays in the new order too, so traversal walks them front to back
+    vector<primitive_ref> sortedRefs(refs.size());
+    vector<sphere_primitive> sortedSpheres;
+    vector<flat_primitive<plane_shape>> sortedPlanes;
+    vector<flat_primitive<disk_shape>> sortedDisks;
+    vector<flat_primitive<quad_shape>> sortedQuads;
+    vector<shared_ptr<hittable>> sortedCustom;
+    sortedSpheres.reserve(spheres.size());
+    sortedCustom.reserve(custom.size());
+    for (size_t i = 0; i < refs.size(); i++)
+    {
+        primitive_ref ref = refs[i < order.size() ? order[i] : i];
+        switch (ref.type)
+        {
+        case primitive_type::sphere: append_reordered(sortedSpheres, spheres, ref.index); break;
+        case primitive_type::plane: append_reordered(sortedPlanes, planes, ref.index); break;
+        case primitive_type::disk: append_reordered(sortedDisks, disks, ref.index); break;
+        case primitive_type::quad: append_reordered(sortedQuads, quads, ref.index); break;
+        default: append_reordered(sortedCustom, custom, ref.index); break;
+        }
+        sortedRefs[i] = ref;
+    }
+    refs = std::move(sortedRefs);
+    spheres = std::move(sortedSpheres);
+    planes = std::move(sortedPlanes);
+    disks = std::move(sortedDisks);
+    quads = std::move(sortedQuads);
+    custom = std::move(sortedCustom);
+}
+
+bool primitive_set::intersect_unbounded(const ray& r, double t_min, double t_max, hit_id& id) const
+{
+    bool hitAnything = false;
+    double far = t_max;
+    for (auto i = static_cast<uint32_t>(boundedCount); i < refs.size(); i++)
+    {
+        if (intersect(i, r, t_min, far, id))
+        {
+            hitAnything = true;
+            far = id.t;
+        }
+    }
+    return hitAnything;
+}
+
+bool primitive_set::occluded_unbounded(const ray& r, double t_min, double t_max) const
+{
+    for (auto i = static_cast<uint32_t>(boundedCount); i < refs.size(); i++)
+    {
+        if (occluded(i, r, t_min, t_max))
+            return true;
+    }
+    return false;
+}
+
+bool primitive_set::intersect(const ray& r, double t_min, double t_max, hit_id& id) const
+{
+    bool hitAnything = false;
+    double far = t_max;
+    for (uint32_t i = 0; i < refs.size(); i++)
+    {
+        if (intersect(i, r, t_min, far, id))
+        {
+            hitAnything = true;
+            far = id.t;
+        }
+    }
+    return hitAnything;
+}
+
+void primitive_set::materialize(const ray& r, const hit_id& id, hit_record& rec) const
+{
+    // custom primitives name themselves in id.prim, so only built-in types arrive here
+    const primitive_ref& ref = refs[id.index];
+    rec.t = id.t;
+    rec.p = r.at(id.t);
+    rec.emitter = nullptr;
+    switch (ref.type)
+    {
+    case primitive_type::sphere:
+    {
+        const sphere_primitive& s = spheres[ref.index];
+        glm::vec3 outward_normal = (rec.p - s.center) / static_cast<float>(s.radius);
+        rec.set_face_normal(r, outward_normal);
+        rec.pMat = &materials[s.material];
+        if (s.emitter != no_emitter)
+            rec.emitter = emitters[s.emitter].get();
+        break;
+    }
+    case primitive_type::plane:
+        rec.set_face_normal(r, planes[ref.index].shape.normal);
+        rec.pMat = &materials[planes[ref.index].material];
+        break;
+    case primitive_type::disk:
+        rec.set_face_normal(r, disks[ref.index].shape.support.normal);
+        rec.pMat = &materials[disks[ref.index].material];
+        break;
+    case primitive_type::quad:
+        rec.set_face_normal(r, quads[ref.index].shape.support.normal);
+        rec.pMat = &materials[quads[ref.index].material];
+        break;
+    default:
+        break;
+    }
+}
+
+bool primitive_set::occluded(const ray& r, double t_min, double t_max) const
+{
+    for (uint32_t i = 0; i < refs.size(); i++)
+    {
+        if (occluded(i, r, t_min, t_max))
+            return true;
+    }
+    return false;
+}
+
+bool primitive_set::bounding_box(aabb& output_box) const
+{
+    output_box = aabb();
+    aabb box;
+    for (uint32_t i = 0; i < refs.size(); i++)
+    {
+        if (!primitive_box(i, box)) return false;
+        output_box.expand(box);
+    }
+    return !refs.empty();
+}
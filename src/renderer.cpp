@@ -0,0 +1,165 @@
+#include "renderer.h"
+#include <cmath>
+
+void accumulation_buffer::reset(int w, int h)
+{
+    width = w;
+    height = h;
+    sum.assign(static_cast<size_t>(w) * h, glm::vec3(0.f));
+    count.assign(sum.size(), 0);
+}
+
+// One camera sample through pixel (i, j); the sampler is positioned on (i, j, s) first.
+static glm::vec3 trace_sample(const camera& cam, const path_integrator& integrator, rtweekend::sampler& rng,
+    int i, int j, int s, int width, int height)
+{
+    float u = static_cast<float>(j) / height;
+    float v = static_cast<float>(i) / width;
+    rng.start_pixel_sample(i, j, s);
+    double jitterU = rtweekend::random_double(rng);
+    double jitterV = rtweekend::random_double(rng);
+    rng.seek(rtweekend::sampler::dim_lens);
+    return integrator(cam.getRayFromScreenPos(u + jitterU / (height - 1), v + jitterV / (width - 1), rng), rng);
+}
+
+renderer::renderer(const render_settings& settings)
+    : config(settings), pool(settings.threads), workers(pool.size()),
+      tilesX((settings.width + settings.tileSize - 1) / settings.tileSize),
+      tilesY((settings.height + settings.tileSize - 1) / settings.tileSize)
+{
+    for (auto& w : workers)
+        w.rng = rtweekend::sampler(settings.samplerType, settings.samples);
+}
+
+void renderer::render(const hittable& world, const camera& cam, std::vector<glm::vec3>& image)
+{
+    image.resize(static_cast<size_t>(config.width) * config.height);
+    sampleCounts.resize(image.size());
+    reset_stats();
+    thread_pool::task_fn task = [&](size_t tile, unsigned worker) {
+        render_tile(tile, worker, world, cam, image);
+    };
+    pool.parallel_for(tile_count(), task);
+}
+
+void renderer::accumulate(const hittable& world, const camera& cam, accumulation_buffer& buffer,
+    int samplesPerPass, const std::atomic<bool>* cancel, const thread_pool::task_fn& onTileDone)
+{
+    if (buffer.width != config.width || buffer.height != config.height)
+        buffer.reset(config.width, config.height);
+    reset_stats();
+    thread_pool::task_fn task = [&](size_t tile, unsigned worker) {
+        if (cancel && cancel->load(std::memory_order_relaxed))
+            return;
+        accumulate_tile(tile, worker, world, cam, buffer, samplesPerPass);
+        if (onTileDone)
+            onTileDone(tile, worker);
+    };
+    pool.parallel_for(tile_count(), task);
+}
+
+void renderer::tile_bounds(size_t tile, int& x0, int& y0, int& x1, int& y1) const
+{
+    x0 = static_cast<int>(tile % tilesX) * config.tileSize;
+    y0 = static_cast<int>(tile / tilesX) * config.tileSize;
+    x1 = std::min(x0 + config.tileSize, config.width);
+    y1 = std::min(y0 + config.tileSize, config.height);
+}
+
+void renderer::reset_stats()
+{
+    for (auto& w : workers) {
+        w.stats = traversal_stats();
+        w.paths = path_stats();
+    }
+}
+
+void renderer::render_tile(size_t tile, unsigned worker, const hittable& world, const camera& cam, std::vector<glm::vec3>& image)
+{
+    auto& rng = workers[worker].rng;
+    auto& stats = thread_traversal_stats();
+    stats = traversal_stats();
+    const int width = config.width;
+    const int height = config.height;
+    const bool adaptive = config.minSamples > 0;
+    const int minSamples = adaptive ? config.minSamples : config.samples;
+    const int batch = std::max(config.sampleBatch, 1);
+    const path_integrator integrator{ world, sampled_lights(), config.maxDepth, config.rrMinDepth, config.skyIntensity, workers[worker].paths };
+    int x0, y0, x1, y1;
+    tile_bounds(tile, x0, y0, x1, y1);
+    for (int j = y0; j < y1; ++j) {
+        for (int i = x0; i < x1; ++i) {
+            // Welford running mean/variance of the sample luminance drives the adaptive stop
+            glm::vec3 color(0.f);
+            double mean = 0.0, m2 = 0.0;
+            int s = 0;
+            while (s < config.samples)
+            {
+                int batchEnd = std::min(s + (s < minSamples ? minSamples - s : batch), config.samples);
+                for (; s < batchEnd; ++s)
+                {
+                    glm::vec3 sample = trace_sample(cam, integrator, rng, i, j, s, width, height);
+                    color += sample;
+                    double y = 0.2126 * sample.x + 0.7152 * sample.y + 0.0722 * sample.z;
+                    double delta = y - mean;
+                    mean += delta / (s + 1);
+                    m2 += delta * (y - mean);
+                }
+                if (!adaptive || s < 2)
+                    continue;
+                double stdError = std::sqrt(m2 / (s - 1) / s);
+                if (stdError <= config.maxRelError * std::max(mean, 1e-3))
+                    break;
+            }
+            color /= static_cast<float>(s);
+            sampleCounts[static_cast<size_t>(j) * width + i] = static_cast<uint32_t>(s);
+            image[static_cast<size_t>(j) * width + i] = color;
+        }
+    }
+    workers[worker].stats.rays += stats.rays;
+    workers[worker].stats.nodesVisited += stats.nodesVisited;
+}
+
+void renderer::accumulate_tile(size_t tile, unsigned worker, const hittable& world, const camera& cam, accumulation_buffer& buffer, int samplesPerPass)
+{
+    auto& rng = workers[worker].rng;
+    auto& stats = thread_traversal_stats();
+    stats = traversal_stats();
+    const int width = config.width;
+    const int height = config.height;
+    const path_integrator integrator{ world, sampled_lights(), config.maxDepth, config.rrMinDepth, config.skyIntensity, workers[worker].paths };
+    int x0, y0, x1, y1;
+    tile_bounds(tile, x0, y0, x1, y1);
+    for (int j = y0; j < y1; ++j) {
+        for (int i = x0; i < x1; ++i) {
+            size_t pixel = static_cast<size_t>(j) * width + i;
+            int first = static_cast<int>(buffer.count[pixel]);
+            for (int s = first; s < first + samplesPerPass; ++s)
+                buffer.sum[pixel] += trace_sample(cam, integrator, rng, i, j, s, width, height);
+            buffer.count[pixel] += samplesPerPass;
+        }
+    }
+    workers[worker].stats.rays += stats.rays;
+    workers[worker].stats.nodesVisited += stats.nodesVisited;
+}
+
+traversal_stats renderer::getStats() const
+{
+    traversal_stats total;
+    for (const auto& w : workers) {
+        total.rays += w.stats.rays;
+        total.nodesVisited += w.stats.nodesVisited;
+    }
+    return total;
+}
+
+path_stats renderer::getPathStats() const
+{
+    path_stats total;
+    for (const auto& w : workers) {
+        total.paths += w.paths.paths;
+        total.segments += w.paths.segments;
+        total.shadowRays += w.paths.shadowRays;
+    }
+    return total;
+}
@@ -0,0 +1,264 @@
+#include "sampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "rtweekend.h"
+
+namespace rtweekend
+{
+    // lowbias32 integer hash (Wellons)
+    static uint32_t hash_u32(uint32_t x)
+    {
+        x ^= x >> 16;
+        x *= 0x7feb352du;
+        x ^= x >> 15;
+        x *= 0x846ca68bu;
+        x ^= x >> 16;
+        return x;
+    }
+
+    static uint32_t hash_combine(uint32_t seed, uint32_t value)
+    {
+        return hash_u32(seed ^ (value + 0x9e3779b9u + (seed << 6) + (seed >> 2)));
+    }
+
+    static uint32_t reverse_bits(uint32_t x)
+    {
+        x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+        x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+        x = ((x >> 4) & 0x0f0f0f0fu) | ((x & 0x0f0f0f0fu) << 4);
+        x = ((x >> 8) & 0x00ff00ffu) | ((x & 0x00ff00ffu) << 8);
+        return (x >> 16) | (x << 16);
+    }
+
+    // The first two Sobol dimensions as 32-bit fractions: van der Corput, and the dimension with
+    // primitive polynomial x + 1. Together they form a (0,2)-sequence.
+    static uint32_t sobol(uint32_t index, int dim)
+    {
+        if (dim == 0)
+            return reverse_bits(index);
+        uint32_t result = 0;
+        for (uint32_t v = 1u << 31; index; index >>= 1, v ^= v >> 1) {
+            if (index & 1u)
+                result ^= v;
+        }
+        return result;
+    }
+
+    // Owen scrambling by hashing, from Burley, "Practical Hash-based Owen Scrambling" (JCGT 2020).
+    static uint32_t nested_uniform_scramble(uint32_t x, uint32_t seed)
+    {
+        x = reverse_bits(x);
+        x ^= x * 0x3d20adeau;
+        x += seed;
+        x *= (seed >> 16) | 1u;
+        x ^= x * 0x05526c56u;
+        x ^= x * 0x53a22864u;
+        return reverse_bits(x);
+    }
+
+    // Random permutation of [0, l) indexed by i, from Kensler, "Correlated Multi-Jittered
+    // Sampling" (Pixar 2013).
+    static uint32_t permute(uint32_t i, uint32_t l, uint32_t p)
+    {
+        uint32_t w = l - 1;
+        w |= w >> 1;
+        w |= w >> 2;
+        w |= w >> 4;
+        w |= w >> 8;
+        w |= w >> 16;
+        do {
+            i ^= p; i *= 0xe170893du;
+            i ^= p >> 16;
+            i ^= (i & w) >> 4;
+            i ^= p >> 8; i *= 0x0929eb3fu;
+            i ^= p >> 23;
+            i ^= (i & w) >> 1; i *= 1u | p >> 27;
+            i *= 0x6935fa69u;
+            i ^= (i & w) >> 11; i *= 0x74dcb303u;
+            i ^= (i & w) >> 2; i *= 0x9e501cc3u;
+            i ^= (i & w) >> 2; i *= 0xc860a3dfu;
+            i &= w;
+            i ^= i >> 5;
+        } while (i >= l);
+        return (i + p) % l;
+    }
+
+    static uint32_t to_fixed(double x)
+    {
+        return static_cast<uint32_t>(std::min(x * 4294967296.0, 4294967295.0));
+    }
+
+    bool parse_sampler_type(const std::string& name, sampler_type& type)
+    {
+        if (name == "independent") type = sampler_type::independent;
+        else if (name == "stratified") type = sampler_type::stratified;
+        else if (name == "sobol") type = sampler_type::sobol;
+        else if (name == "bluenoise") type = sampler_type::blue_noise;
+        else return false;
+        return true;
+    }
+
+    // Void and cluster (Ulichney 1993) on a torus: a Gaussian energy per cell measures how
+    // crowded its neighbourhood is; ranks go to the tightest clusters of the initial pattern
+    // first, then to the largest voids, then to the tightest clusters of the remaining holes.
+    static std::vector<uint16_t> build_blue_noise()
+    {
+        const int size = blue_noise_size;
+        const int cells = size * size;
+        const float sigma = 1.5f;
+        std::vector<float> kernel(cells);
+        for (int y = 0; y < size; y++) {
+            for (int x = 0; x < size; x++) {
+                int dx = std::min(x, size - x), dy = std::min(y, size - y);
+                kernel[y * size + x] = std::exp(-(dx * dx + dy * dy) / (2 * sigma * sigma));
+            }
+        }
+        std::vector<uint8_t> bits(cells, 0);
+        std::vector<float> energy(cells, 0.f);
+        auto splat = [&](int cell, float sign) {
+            int cx = cell % size, cy = cell / size;
+            for (int y = 0; y < size; y++) {
+                const float* row = &kernel[((y - cy) & (size - 1)) * size];
+                for (int x = 0; x < size; x++)
+                    energy[y * size + x] += sign * row[(x - cx) & (size - 1)];
+            }
+        };
+        auto tightest = [&](uint8_t value) {
+            int best = -1;
+            for (int c = 0; c < cells; c++) {
+                if (bits[c] == value && (best < 0 || energy[c] > energy[best]))
+                    best = c;
+            }
+            return best;
+        };
+        auto largest_void = [&](uint8_t value) {
+            int best = -1;
+            for (int c = 0; c < cells; c++) {
+                if (bits[c] == value && (best < 0 || energy[c] < energy[best]))
+                    best = c;
+            }
+            return best;
+        };
+
+        // initial pattern: 10% random points, relaxed by moving the tightest cluster point into
+        // the largest void until that is where it came from
+        pcg32 rng(0x2545f491u);
+        const int initial = cells / 10;
+        for (int placed = 0; placed < initial;) {
+            int c = static_cast<int>(rng.next_uint() % cells);
+            if (bits[c]) continue;
+            bits[c] = 1;
+            splat(c, 1.f);
+            placed++;
+        }
+        while (true) {
+            int cluster = tightest(1);
+            bits[cluster] = 0;
+            splat(cluster, -1.f);
+            int hole = largest_void(0);
+            bits[hole] = 1;
+            splat(hole, 1.f);
+            if (hole == cluster) break;
+        }
+        const std::vector<uint8_t> prototype = bits;
+        const std::vector<float> prototypeEnergy = energy;
+
+        std::vector<uint16_t> rank(cells);
+        for (int r = initial - 1; r >= 0; r--) {
+            int c = tightest(1);
+            bits[c] = 0;
+            splat(c, -1.f);
+            rank[c] = static_cast<uint16_t>(r);
+        }
+        bits = prototype;
+        energy = prototypeEnergy;
+        for (int r = initial; r < cells / 2; r++) {
+            int c = largest_void(0);
+            bits[c] = 1;
+            splat(c, 1.f);
+            rank[c] = static_cast<uint16_t>(r);
+        }
+        // past half full the holes are the minority pattern, so their energy takes over
+        std::fill(energy.begin(), energy.end(), 0.f);
+        for (int c = 0; c < cells; c++) {
+            if (!bits[c]) splat(c, 1.f);
+        }
+        for (int r = cells / 2; r < cells; r++) {
+            int c = tightest(0);
+            bits[c] = 1;
+            splat(c, -1.f);
+            rank[c] = static_cast<uint16_t>(r);
+        }
+        return rank;
+    }
+
+    const uint16_t* blue_noise_tile()
+    {
+        static const std::vector<uint16_t> tile = build_blue_noise();
+        return tile.data();
+    }
+
+    sampler::sampler(sampler_type type, int samplesPerPixel, uint32_t seed)
+        : type(type), seed(seed)
+    {
+        // the most square grid of columns x rows holding the pixel's samples
+        strataCount = static_cast<uint32_t>(std::max(samplesPerPixel, 1));
+        strataColumns = std::max(1u, static_cast<uint32_t>(std::sqrt(static_cast<double>(strataCount))));
+        strataRows = (strataCount + strataColumns - 1) / strataColumns;
+        if (type == sampler_type::blue_noise)
+            blueNoise = blue_noise_tile();
+    }
+
+    void sampler::fill_pattern(uint32_t block)
+    {
+        if (type == sampler_type::stratified) {
+            stratified_pair(2 * block, values);
+            stratified_pair(2 * block + 1, values + 2);
+        }
+        else {
+            sobol_pair(2 * block, values);
+            sobol_pair(2 * block + 1, values + 2);
+        }
+    }
+
+    // Correlated multi-jittered sample: the pixel's samples fall one per cell of a columns x rows
+    // grid and one per row and column of the finer grid inside it. Each pixel, bounce, pair and
+    // round of strataCount samples gets its own permutation.
+    void sampler::stratified_pair(uint32_t pair, uint32_t out[2]) const
+    {
+        uint32_t p = hash_combine(hash_combine(hash_combine(hash_combine(seed, px), py), (bounce << 8) | pair), sample / strataCount);
+        uint32_t s = permute(sample % strataCount, strataCount, p * 0x51633e2du);
+        uint32_t column = s % strataColumns, row = s / strataColumns;
+        uint32_t sx = permute(column, strataColumns, p * 0x68bc21ebu);
+        uint32_t sy = permute(row, strataRows, p * 0x02e5be93u);
+        double jx = hash_combine(p * 0xa399d265u, s) * (1.0 / 4294967296.0);
+        double jy = hash_combine(p * 0x711ad6a5u, s) * (1.0 / 4294967296.0);
+        out[0] = to_fixed((column + (sy + jx) / strataRows) / strataColumns);
+        out[1] = to_fixed((row + (sx + jy) / strataColumns) / strataRows);
+    }
+
+    // Padded Owen-scrambled Sobol: each pair shuffles the sample index and scrambles both
+    // dimensions with its own seeds, which decorrelates the pairs without higher Sobol dimensions.
+    void sampler::sobol_pair(uint32_t pair, uint32_t out[2]) const
+    {
+        uint32_t pairSeed = hash_combine(seed, (bounce << 8) | pair);
+        if (type == sampler_type::sobol)
+            pairSeed = hash_combine(hash_combine(pairSeed, px), py);
+        uint32_t index = nested_uniform_scramble(sample, pairSeed);
+        out[0] = nested_uniform_scramble(sobol(index, 0), hash_combine(pairSeed, 1));
+        out[1] = nested_uniform_scramble(sobol(index, 1), hash_combine(pairSeed, 2));
+        if (type != sampler_type::blue_noise)
+            return;
+        // Cranley-Patterson rotation by the tile, shifted along the R2 sequence per dimension so
+        // every dimension sees a different, still blue, offset field
+        for (uint32_t k = 0; k < 2; k++) {
+            double key = ((bounce << 8) | (2 * pair + k)) + 1.0;
+            auto ox = static_cast<uint32_t>((key * 0.7548776662466927 - std::floor(key * 0.7548776662466927)) * blue_noise_size);
+            auto oy = static_cast<uint32_t>((key * 0.5698402909980532 - std::floor(key * 0.5698402909980532)) * blue_noise_size);
+            uint32_t rank = blueNoise[((py + oy) & (blue_noise_size - 1)) * blue_noise_size + ((px + ox) & (blue_noise_size - 1))];
+            out[k] += (rank << 20) + (1u << 19);
+        }
+    }
+}
@@ -0,0 +1,89 @@
+#include "scene.h"
+
+hittable_list random_scene() {
+    hittable_list world;
+    rtweekend::pcg32 rng;
+
+    auto ground_material = make_shared<lambertian>(vec3(0.5, 0.5, 0.5));
+    world.add(make_shared<plane>(vec3(0, 0, 0), vec3(0, 1, 0), ground_material));
+
+    for (int a = -11; a < 11; a++) {
+        for (int b = -11; b < 11; b++) {
+            auto choose_mat = rtweekend::random_double(rng);
+            vec3 center(a + 0.9 * rtweekend::random_double(rng), 0.2, b + 0.9 * rtweekend::random_double(rng));
+
+            if ((center - vec3(4, 0.2, 0)).length() > 0.9) {
+                shared_ptr<material> sphere_material;
+
+                if (choose_mat < 0.8) {
+                    // diffuse
+                    auto albedo = vec3(rtweekend::random_double(rng), rtweekend::random_double(rng), rtweekend::random_double(rng));
+                    sphere_material = make_shared<lambertian>(albedo);
+                    world.add(make_shared<sphere>(center, 0.2, sphere_material));
+                }
+                else if (choose_mat < 0.95) {
+                    // metal
+                    auto albedo = vec3(rtweekend::random_double(rng, 0.5, 1.0), rtweekend::random_double(rng, 0.5, 1.0), rtweekend::random_double(rng, 0.5, 1.0));
+                    auto fuzz = rtweekend::random_double(rng, 0, 0.5);
+                    sphere_material = make_shared<FuzzyMetal>(albedo, fuzz);
+                    world.add(make_shared<sphere>(center, 0.2, sphere_material));
+                }
+                else {
+                    // glass
+                    sphere_material = make_shared<dielectric>(1.5);
+                    world.add(make_shared<sphere>(center, 0.2, sphere_material));
+                }
+            }
+        }
+    }
+
+    auto material1 = make_shared<dielectric>(1.5);
+    world.add(make_shared<sphere>(vec3(0, 1, 0), 1.0, material1));
+
+    auto material2 = make_shared<lambertian>(vec3(0.4, 0.2, 0.1));
+    world.add(make_shared<sphere>(vec3(-4, 1, 0), 1.0, material2));
+
+    auto material3 = make_shared<metal>(vec3(0.7, 0.6, 0.5));
+    world.add(make_shared<sphere>(vec3(4, 1, 0), 1.0, material3));
+
+    return world;
+}
+
+hittable_list random_scene_lights() {
+    hittable_list world = random_scene();
+
+    auto warm = make_shared<diffuse_light>(vec3(64, 48, 32));
+    auto cool = make_shared<diffuse_light>(vec3(24, 40, 72));
+    world.add(make_shared<sphere>(vec3(2, 0.6, 2), 0.12, warm));
+    world.add(make_shared<sphere>(vec3(-2, 0.8, -1.5), 0.12, cool));
+    world.add(make_shared<sphere>(vec3(6, 0.7, -2), 0.12, warm));
+    world.add(make_shared<sphere>(vec3(0, 2.6, 0), 0.2, make_shared<diffuse_light>(vec3(48, 48, 48))));
+
+    return world;
+}
+
+hittable_list procedural_scene(int count) {
+    hittable_list world;
+    rtweekend::pcg32 rng;
+
+    auto ground_material = make_shared<lambertian>(vec3(0.5, 0.5, 0.5));
+    world.add(make_shared<plane>(vec3(0, 0, 0), vec3(0, 1, 0), ground_material));
+
+    const double extent = std::cbrt(static_cast<double>(count)) * 0.5;
+    const double radius = 0.2;
+    for (int i = 0; i < count; i++) {
+        vec3 center(rtweekend::random_double(rng) * 2 * extent - extent, rtweekend::random_double(rng) * 2 * extent,
+            rtweekend::random_double(rng) * 2 * extent - extent);
+        auto albedo = vec3(rtweekend::random_double(rng), rtweekend::random_double(rng), rtweekend::random_double(rng));
+        world.add(make_shared<sphere>(center, radius, make_shared<lambertian>(albedo)));
+    }
+
+    return world;
+}
+
+blurcamera random_scene_camera(float aspect_ratio) {
+    glm::vec3 eye(13, 2, 3);
+    glm::vec3 center(0, 0, 0);
+    glm::vec3 up(0.f, 1.f, 0.f);
+    return blurcamera(eye, center, up, 10, 2, 2 * aspect_ratio, 0.1);
+}
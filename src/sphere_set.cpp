@@ -0,0 +1,207 @@
+#include "sphere_set.h"
+#include "primitive_set.h"
+#include <cmath>
+#include <limits>
+
+sphere_set::sphere_set(const hittable_list& list)
+{
+    for (const auto& obj : list.getObjects())
+    {
+        auto s = std::dynamic_pointer_cast<sphere>(obj);
+        if (!s)
+            throw std::invalid_argument("sphere_set: object is not a sphere");
+        add(s->center, static_cast<float>(s->radius), s->pMat, s);
+    }
+}
+
+void sphere_set::resize(size_t n)
+{
+    // padding lanes hold a zero-radius sphere at the origin and are masked off by the kernel
+    size_t padded = n + simd_width - 1;
+    centerX.resize(padded, 0.f);
+    centerY.resize(padded, 0.f);
+    centerZ.resize(padded, 0.f);
+    radius2.resize(padded, 0.f);
+    materialId.resize(padded, 0);
+    emitterId.resize(padded, no_emitter);
+    count = n;
+}
+
+void sphere_set::add(const glm::vec3& center, float radius, shared_ptr<material> mat, shared_ptr<const hittable> source)
+{
+    uint32_t id = materials.add(mat);
+    size_t i = count;
+    resize(count + 1);
+    centerX[i] = center.x;
+    centerY[i] = center.y;
+    centerZ[i] = center.z;
+    radius2[i] = radius * radius;
+    materialId[i] = id;
+    if (source && mat->getRecord().type == material_type::diffuse_light) {
+        emitterId[i] = static_cast<uint32_t>(emitters.size());
+        emitters.push_back(std::move(source));
+    }
+}
+
+aabb sphere_set::sphere_box(uint32_t index) const
+{
+    glm::vec3 center(centerX[index], centerY[index], centerZ[index]);
+    glm::vec3 extent(std::sqrt(radius2[index]));
+    return aabb(center - extent, center + extent);
+}
+
+void sphere_set::permute(const vector<uint32_t>& order)
+{
+    sphere_set sorted;
+    sorted.materials = materials;
+    sorted.emitters = emitters;
+    sorted.resize(count);
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        uint32_t from = order[i];
+        sorted.centerX[i] = centerX[from];
+        sorted.centerY[i] = centerY[from];
+        sorted.centerZ[i] = centerZ[from];
+        sorted.radius2[i] = radius2[from];
+        sorted.materialId[i] = materialId[from];
+        sorted.emitterId[i] = emitterId[from];
+    }
+    *this = std::move(sorted);
+}
+
+// Same quadratic as sphere::hit, but with the discriminant taken as r^2 - |f|^2, f being the
+// offset from the center to the closest point on the line. That avoids the cancellation of
+// b^2 - a*c in float for large spheres such as the ground.
+bool sphere_set::intersect_range(const ray& r, uint32_t first, uint32_t n, float t_min, float& t_max, uint32_t& index, bool anyHit) const
+{
+    const glm::vec3 o = r.origin();
+    const glm::vec3 d = r.direction();
+    const float invA = 1.f / glm::dot(d, d);
+    bool found = false;
+#if defined(RT_HAVE_AVX)
+    const __m256 ox = _mm256_set1_ps(o.x), oy = _mm256_set1_ps(o.y), oz = _mm256_set1_ps(o.z);
+    const __m256 dx = _mm256_set1_ps(d.x), dy = _mm256_set1_ps(d.y), dz = _mm256_set1_ps(d.z);
+    const __m256 inv = _mm256_set1_ps(invA);
+    const __m256 tMin = _mm256_set1_ps(t_min);
+    const __m256 lane = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256 inf = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+    for (uint32_t base = first; base < first + n; base += simd_width)
+    {
+        __m256 ocx = _mm256_sub_ps(ox, _mm256_loadu_ps(&centerX[base]));
+        __m256 ocy = _mm256_sub_ps(oy, _mm256_loadu_ps(&centerY[base]));
+        __m256 ocz = _mm256_sub_ps(oz, _mm256_loadu_ps(&centerZ[base]));
+        __m256 b = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ocx, dx), _mm256_mul_ps(ocy, dy)), _mm256_mul_ps(ocz, dz)), inv);
+        __m256 fx = _mm256_sub_ps(ocx, _mm256_mul_ps(b, dx));
+        __m256 fy = _mm256_sub_ps(ocy, _mm256_mul_ps(b, dy));
+        __m256 fz = _mm256_sub_ps(ocz, _mm256_mul_ps(b, dz));
+        __m256 disc = _mm256_sub_ps(_mm256_loadu_ps(&radius2[base]),
+            _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(fx, fx), _mm256_mul_ps(fy, fy)), _mm256_mul_ps(fz, fz)));
+        __m256 valid = _mm256_and_ps(_mm256_cmp_ps(disc, _mm256_setzero_ps(), _CMP_GE_OQ),
+            _mm256_cmp_ps(lane, _mm256_set1_ps(static_cast<float>(first + n - base)), _CMP_LT_OQ));
+        __m256 s = _mm256_sqrt_ps(_mm256_mul_ps(_mm256_max_ps(disc, _mm256_setzero_ps()), inv));
+        __m256 tNear = _mm256_sub_ps(_mm256_sub_ps(_mm256_setzero_ps(), b), s);
+        __m256 tFar = _mm256_sub_ps(s, b);
+        __m256 t = _mm256_blendv_ps(tFar, tNear, _mm256_cmp_ps(tNear, tMin, _CMP_GE_OQ));
+        valid = _mm256_and_ps(valid, _mm256_cmp_ps(t, tMin, _CMP_GE_OQ));
+        valid = _mm256_and_ps(valid, _mm256_cmp_ps(t, _mm256_set1_ps(t_max), _CMP_LE_OQ));
+        int mask = _mm256_movemask_ps(valid);
+        if (!mask) continue;
+        if (anyHit) return true;
+        alignas(32) float ts[simd_width];
+        _mm256_store_ps(ts, _mm256_blendv_ps(inf, t, valid));
+        for (int i = 0; i < simd_width; i++)
+        {
+            if ((mask & (1 << i)) && ts[i] <= t_max)
+            {
+                t_max = ts[i];
+                index = base + i;
+                found = true;
+            }
+        }
+    }
+#else
+    for (uint32_t i = first; i < first + n; i++)
+    {
+        float ocx = o.x - centerX[i], ocy = o.y - centerY[i], ocz = o.z - centerZ[i];
+        float b = (ocx * d.x + ocy * d.y + ocz * d.z) * invA;
+        float fx = ocx - b * d.x, fy = ocy - b * d.y, fz = ocz - b * d.z;
+        float disc = radius2[i] - (fx * fx + fy * fy + fz * fz);
+        if (disc < 0) continue;
+        float s = std::sqrt(disc * invA);
+        float t = -b - s;
+        if (t < t_min) t = s - b;
+        if (t < t_min || t > t_max) continue;
+        t_max = t;
+        index = i;
+        found = true;
+        if (anyHit) break;
+    }
+#endif
+    return found;
+}
+
+void sphere_set::materialize(const ray& r, const hit_id& id, hit_record& rec) const
+{
+    uint32_t index = id.index;
+    glm::vec3 center(centerX[index], centerY[index], centerZ[index]);
+    rec.t = id.t;
+    rec.p = r.at(id.t);
+    glm::vec3 outward_normal = (rec.p - center) / std::sqrt(radius2[index]);
+    rec.set_face_normal(r, outward_normal);
+    rec.pMat = &materials[materialId[index]];
+    rec.emitter = emitterId[index] != no_emitter ? emitters[emitterId[index]].get() : nullptr;
+}
+
+bool sphere_set::intersect(const ray& r, double t_min, double t_max, hit_id& id) const
+{
+    float nearest = static_cast<float>(t_max);
+    uint32_t index = 0;
+    if (!intersect_range(r, 0, static_cast<uint32_t>(count), static_cast<float>(t_min), nearest, index))
+        return false;
+    id = { nearest, this, index };
+    return true;
+}
+
+bool sphere_set::occluded(const ray& r, double t_min, double t_max) const
+{
+    float limit = static_cast<float>(t_max);
+    uint32_t index;
+    return intersect_range(r, 0, static_cast<uint32_t>(count), static_cast<float>(t_min), limit, index, true);
+}
+
+bool sphere_set::bounding_box(aabb& output_box) const
+{
+    output_box = aabb();
+    for (uint32_t i = 0; i < count; i++)
+        output_box.expand(sphere_box(i));
+    return count > 0;
+}
+
+shared_ptr<hittable> make_sphere_accelerator(const hittable_list& list, bvh_layout layout)
+{
+    hittable_list spheres, others;
+    for (const auto& obj : list.getObjects())
+    {
+        if (std::dynamic_pointer_cast<sphere>(obj))
+            spheres.add(obj);
+        else
+            others.add(obj);
+    }
+    sphere_set set(spheres);
+    shared_ptr<hittable> accel;
+    if (set.size() < brute_force_limit)
+        accel = make_shared<sphere_set>(std::move(set));
+    else if (layout == bvh_layout::bvh4)
+        accel = make_shared<sphere_bvh<wide_bvh_tree<4>>>(std::move(set));
+    else if (layout == bvh_layout::bvh8)
+        accel = make_shared<sphere_bvh<wide_bvh_tree<8>>>(std::move(set));
+    else
+        accel = make_shared<sphere_bvh<bvh_tree>>(std::move(set));
+    if (others.getObjects().empty())
+        return accel;
+
+    // everything that is not a sphere (e.g. the ground plane) is tested first by a primitive_set
+    hittable_list combined(make_shared<primitive_set>(others));
+    combined.add(accel);
+    return make_shared<hittable_list>(combined);
+}
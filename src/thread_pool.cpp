@@ -0,0 +1,90 @@
+#include "thread_pool.h"
+
+thread_pool::thread_pool(unsigned threadCount)
+{
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned i = 0; i < threadCount; i++)
+        queues.push_back(std::make_unique<task_queue>());
+    for (unsigned i = 0; i < threadCount; i++)
+        workers.emplace_back(&thread_pool::worker_loop, this, i);
+}
+
+thread_pool::~thread_pool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& t : workers)
+        t.join();
+}
+
+void thread_pool::parallel_for(size_t count, const task_fn& task)
+{
+    if (count == 0) return;
+    std::unique_lock<std::mutex> lock(mutex);
+    // publish the job before any task becomes visible, a worker still draining the queues from
+    // the previous call may pick the new tasks up right away
+    job = &task;
+    remaining = count;
+    for (size_t i = 0; i < count; i++)
+    {
+        auto& q = *queues[i % queues.size()];
+        std::lock_guard<std::mutex> queueLock(q.mutex);
+        q.tasks.push_back(i);
+    }
+    generation++;
+    wake.notify_all();
+    done.wait(lock, [this] { return remaining == 0; });
+    job = nullptr;
+}
+
+bool thread_pool::pop(unsigned id, size_t& task)
+{
+    auto& q = *queues[id];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if (q.tasks.empty()) return false;
+    task = q.tasks.front();
+    q.tasks.pop_front();
+    return true;
+}
+
+bool thread_pool::steal(unsigned id, size_t& task)
+{
+    for (size_t i = 1; i < queues.size(); i++)
+    {
+        auto& q = *queues[(id + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (q.tasks.empty()) continue;
+        task = q.tasks.back();
+        q.tasks.pop_back();
+        return true;
+    }
+    return false;
+}
+
+void thread_pool::worker_loop(unsigned id)
+{
+    uint64_t seen = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+        }
+        size_t task;
+        while (pop(id, task) || steal(id, task))
+        {
+            (*job.load())(task, id);
+            if (--remaining == 0)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                done.notify_all();
+            }
+        }
+    }
+}
@@ -0,0 +1,20 @@
+#include "wide_bvh.h"
+
+bool parse_bvh_layout(const std::string& name, bvh_layout& layout)
+{
+    if (name == "binary") layout = bvh_layout::binary;
+    else if (name == "bvh4") layout = bvh_layout::bvh4;
+    else if (name == "bvh8") layout = bvh_layout::bvh8;
+    else return false;
+    return true;
+}
+
+shared_ptr<hittable> make_accelerator(const hittable_list& list, bvh_layout layout)
+{
+    switch (layout)
+    {
+    case bvh_layout::bvh4: return make_shared<bvh4>(list);
+    case bvh_layout::bvh8: return make_shared<bvh8>(list);
+    default: return make_shared<linear_bvh>(list);
+    }
+}
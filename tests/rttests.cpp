@@ -0,0 +1,367 @@
+// Regression tests for the tracing core. Each case prints one line and the executable exits with
+// the number of failed cases, so ctest reports any of them.
+#include <iostream>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "glm/glm.hpp"
+#include "rtweekend.h"
+#include "hittable.h"
+#include "planar.h"
+#include "material.h"
+#include "primitive_set.h"
+#include "bvh.h"
+#include "wide_bvh.h"
+#include "sphere_set.h"
+#include "light.h"
+#include "camera.h"
+#include "sampler.h"
+#include "scene.h"
+#include "renderer.h"
+
+using namespace std;
+
+static int failures = 0;
+static const double infinity = std::numeric_limits<double>::infinity();
+
+static void report(const string& name, bool passed, const string& detail = "")
+{
+    cout << (passed ? "pass " : "FAIL ") << name;
+    if (!detail.empty())
+        cout << ": " << detail;
+    cout << endl;
+    if (!passed)
+        failures++;
+}
+
+// Known-answer vectors published with Random123 (kat_vectors, philox4x32 10 rounds).
+static void test_philox_known_answers()
+{
+    struct vector_case { uint32_t counter[4]; uint32_t key[2]; uint32_t expected[4]; };
+    const vector_case cases[] = {
+        { { 0, 0, 0, 0 }, { 0, 0 }, { 0x6627e8d5u, 0xe169c58du, 0xbc57ac4cu, 0x9b00dbd8u } },
+        { { 0xffffffffu, 0xffffffffu, 0xffffffffu, 0xffffffffu }, { 0xffffffffu, 0xffffffffu },
+            { 0x408f276du, 0x41c83b0eu, 0xa20bc7c6u, 0x6d5451fdu } },
+        { { 0x243f6a88u, 0x85a308d3u, 0x13198a2eu, 0x03707344u }, { 0xa4093822u, 0x299f31d0u },
+            { 0xd16cfe09u, 0x94fdccebu, 0x5001e420u, 0x24126ea1u } },
+    };
+    bool ok = true;
+    for (const vector_case& c : cases)
+    {
+        uint32_t out[4];
+        rtweekend::philox4x32(c.counter, c.key[0], c.key[1], out);
+        for (int i = 0; i < 4; i++)
+            ok = ok && out[i] == c.expected[i];
+    }
+    report("philox4x32-10 known answers", ok);
+}
+
+// Every value must depend only on (pixel, sample, bounce, dimension), not on what was drawn before.
+static void test_sampler_is_pure()
+{
+    const rtweekend::sampler_type types[] = { rtweekend::sampler_type::independent, rtweekend::sampler_type::stratified,
+        rtweekend::sampler_type::sobol, rtweekend::sampler_type::blue_noise };
+    const char* names[] = { "independent", "stratified", "sobol", "blue_noise" };
+    for (int t = 0; t < 4; t++)
+    {
+        rtweekend::sampler forward(types[t], 16, 7);
+        rtweekend::sampler shuffled(types[t], 16, 7);
+        bool ok = true;
+        for (int s = 0; s < 20 && ok; s++)
+        {
+            for (int bounce = 0; bounce < 3 && ok; bounce++)
+            {
+                uint32_t expected[8];
+                forward.start_pixel_sample(5, 9, s);
+                forward.start_bounce(bounce);
+                for (uint32_t d = 0; d < 8; d++)
+                    expected[d] = forward.next_uint();
+                // another pixel in between, then the dimensions in reverse order
+                shuffled.start_pixel_sample(6, 9, s);
+                shuffled.next_uint();
+                shuffled.start_pixel_sample(5, 9, s);
+                shuffled.start_bounce(bounce);
+                for (uint32_t d = 8; d-- > 0;)
+                {
+                    shuffled.seek(d);
+                    ok = ok && shuffled.next_uint() == expected[d];
+                }
+            }
+        }
+        report(string("sampler is pure (") + names[t] + ")", ok);
+    }
+}
+
+// The first pair of dimensions must put one sample in every 1D stratum of both axes (and every
+// 4x4 cell for the (0,2)-sequence).
+static void test_sampler_stratification()
+{
+    struct stratified_case { rtweekend::sampler_type type; int samples; bool grid; const char* name; };
+    const stratified_case cases[] = {
+        { rtweekend::sampler_type::stratified, 16, false, "stratified, 16 spp" },
+        { rtweekend::sampler_type::stratified, 12, false, "stratified, 12 spp" },
+        { rtweekend::sampler_type::sobol, 16, true, "sobol, 16 spp" },
+    };
+    for (const stratified_case& c : cases)
+    {
+        rtweekend::sampler rng(c.type, c.samples);
+        bool ok = true;
+        for (int pixel = 0; pixel < 64 && ok; pixel++)
+        {
+            vector<int> xs(c.samples, 0), ys(c.samples, 0), cells(16, 0);
+            for (int s = 0; s < c.samples; s++)
+            {
+                rng.start_pixel_sample(pixel % 8, pixel / 8, s);
+                double u = rng.next_double(), v = rng.next_double();
+                xs[static_cast<int>(u * c.samples)]++;
+                ys[static_cast<int>(v * c.samples)]++;
+                cells[static_cast<int>(u * 4) * 4 + static_cast<int>(v * 4)]++;
+            }
+            for (int i = 0; i < c.samples; i++)
+                ok = ok && xs[i] == 1 && ys[i] == 1;
+            if (c.grid)
+                for (int cell : cells)
+                    ok = ok && cell == 1;
+        }
+        report(string("sampler stratification (") + c.name + ")", ok);
+    }
+}
+
+// random_scene() plus every built-in planar type, emitters and a nested list, which the
+// accelerators keep as a custom primitive.
+static hittable_list mixed_scene()
+{
+    hittable_list world = random_scene();
+    auto light = make_shared<diffuse_light>(vec3(4, 4, 4));
+    auto red = make_shared<lambertian>(vec3(0.7, 0.2, 0.2));
+    world.add(make_shared<disk>(vec3(-3, 2.5, 2), vec3(0.3, 1, 0.2), 0.8f, red));
+    world.add(make_shared<quad>(vec3(1, 3, -2), vec3(2, 0, 0), vec3(0, 0.5, 2), light));
+    world.add(make_shared<sphere>(vec3(2, 0.6, 2), 0.3, light));
+    hittable_list nested;
+    nested.add(make_shared<sphere>(vec3(-2, 0.8, -1.5), 0.25, light));
+    nested.add(make_shared<quad>(vec3(-5, 0.1, 3), vec3(1, 0, 0), vec3(0, 1, 0), red));
+    world.add(make_shared<hittable_list>(nested));
+    return world;
+}
+
+static bool same_material(const material_record& a, const material_record& b)
+{
+    return a.type == b.type && a.albedo == b.albedo && a.param == b.param;
+}
+
+// Compares nearest hits, materials, emitters and occlusion of an accelerator with the plain list
+// along random rays through the scene. tTolerance is relative; the SoA kernel works in float, and
+// where random_scene()'s spheres overlap it may then report the other of two surfaces at nearly
+// the same t. Those ties are counted apart and only allowed, rarely, with a tolerance.
+static void compare_with_list(const string& name, const hittable& accel, const hittable_list& list, double tTolerance)
+{
+    rtweekend::pcg32 rng(11);
+    const int rayCount = 20000;
+    int mismatches = 0, ties = 0, hits = 0;
+    for (int i = 0; i < rayCount; i++)
+    {
+        glm::vec3 origin(rtweekend::random_double(rng, -8, 8), rtweekend::random_double(rng, 0.1, 4),
+            rtweekend::random_double(rng, -8, 8));
+        glm::vec3 direction(rtweekend::random_double(rng, -1, 1), rtweekend::random_double(rng, -1, 1),
+            rtweekend::random_double(rng, -1, 1));
+        ray r(origin, direction);
+        hit_record expected, actual;
+        bool hitList = list.hit(r, .001, infinity, expected);
+        bool hitAccel = accel.hit(r, .001, infinity, actual);
+        if (hitList != hitAccel || accel.occluded(r, .001, infinity) != hitList) {
+            mismatches++;
+            continue;
+        }
+        if (!hitList)
+            continue;
+        hits++;
+        if (std::fabs(expected.t - actual.t) > tTolerance * std::fmax(1.0, expected.t)) {
+            mismatches++;
+            continue;
+        }
+        bool sameSurface = glm::length(expected.normal - actual.normal) <= 1e-3f
+            && expected.front_face == actual.front_face
+            && same_material(*expected.pMat, *actual.pMat);
+        if (!sameSurface)
+            ties++;
+        else if (emitted(*expected.pMat) != glm::vec3(0.f) && expected.emitter != actual.emitter)
+            mismatches++;
+    }
+    report("accelerator matches list (" + name + ")", mismatches == 0 && ties <= (tTolerance > 0 ? rayCount / 1000 : 0),
+        to_string(mismatches) + " mismatches and " + to_string(ties) + " ties on " + to_string(rayCount) + " rays, "
+        + to_string(hits) + " hits");
+}
+
+static void test_accelerators_match_list()
+{
+    hittable_list scene = mixed_scene();
+    const bvh_layout layouts[] = { bvh_layout::binary, bvh_layout::bvh4, bvh_layout::bvh8 };
+    const char* names[] = { "binary", "bvh4", "bvh8" };
+    for (int l = 0; l < 3; l++)
+    {
+        compare_with_list(names[l], *make_accelerator(scene, layouts[l]), scene, 0.0);
+        compare_with_list(string(names[l]) + " soa", *make_sphere_accelerator(scene, layouts[l]), scene, 1e-4);
+    }
+    compare_with_list("primitive_set", primitive_set(scene), scene, 0.0);
+}
+
+// Objects that primitive_set stores by value must hit exactly like the same objects reached
+// through the virtual interface as custom primitives.
+static void test_custom_matches_builtin()
+{
+    hittable_list scene = mixed_scene();
+    primitive_set builtin(scene);
+    primitive_set custom;
+    for (const auto& obj : scene.getObjects())
+        custom.add_custom(obj);
+    compare_with_list("custom primitives", custom, scene, 0.0);
+
+    rtweekend::pcg32 rng(5);
+    int mismatches = 0;
+    for (int i = 0; i < 20000; i++)
+    {
+        ray r(glm::vec3(rtweekend::random_double(rng, -8, 8), rtweekend::random_double(rng, 0.1, 4), rtweekend::random_double(rng, -8, 8)),
+            glm::vec3(rtweekend::random_double(rng, -1, 1), rtweekend::random_double(rng, -1, 1), rtweekend::random_double(rng, -1, 1)));
+        hit_record a, b;
+        bool hitA = builtin.hit(r, .001, infinity, a);
+        bool hitB = custom.hit(r, .001, infinity, b);
+        if (hitA != hitB || (hitA && (a.t != b.t || a.normal != b.normal || !same_material(*a.pMat, *b.pMat))))
+            mismatches++;
+    }
+    report("custom matches built-in", mismatches == 0, to_string(mismatches) + " mismatches");
+}
+
+// accumulate() must report every tile exactly once per pass, from a valid worker, and the tiles
+// must cover the image without overlap.
+static void test_tiles_reported_once()
+{
+    render_settings settings;
+    settings.width = 70;
+    settings.height = 50;
+    settings.tileSize = 16;
+    settings.threads = 3;
+    settings.maxDepth = 4;
+    renderer tracer(settings);
+    hittable_list scene = random_scene();
+    auto world = make_accelerator(scene, bvh_layout::binary);
+    accumulation_buffer buffer;
+    buffer.reset(settings.width, settings.height);
+
+    vector<int> reports(tracer.tile_count(), 0);
+    std::mutex reportMutex;
+    bool validWorker = true;
+    auto onTileDone = [&](size_t tile, unsigned worker) {
+        std::lock_guard<std::mutex> lock(reportMutex);
+        reports[tile]++;
+        validWorker = validWorker && worker < tracer.thread_count();
+    };
+    const int passes = 2;
+    for (int pass = 0; pass < passes; pass++)
+        tracer.accumulate(*world, random_scene_camera(1.4f), buffer, 1, nullptr, onTileDone);
+
+    bool ok = validWorker;
+    for (int count : reports)
+        ok = ok && count == passes;
+    vector<int> coverage(static_cast<size_t>(settings.width) * settings.height, 0);
+    for (size_t tile = 0; tile < tracer.tile_count(); tile++)
+    {
+        int x0, y0, x1, y1;
+        tracer.tile_bounds(tile, x0, y0, x1, y1);
+        for (int y = y0; y < y1; y++)
+            for (int x = x0; x < x1; x++)
+                coverage[static_cast<size_t>(y) * settings.width + x]++;
+    }
+    for (size_t i = 0; i < coverage.size(); i++)
+        ok = ok && coverage[i] == 1 && buffer.count[i] == static_cast<uint32_t>(passes);
+    report("tiles reported once per pass", ok);
+}
+
+// The image is a pure function of the settings that shape it, not of threads or tiles.
+static void test_render_independent_of_threads()
+{
+    hittable_list scene = random_scene_lights();
+    auto world = make_accelerator(scene, bvh_layout::bvh4);
+    light_list lights(scene);
+    vector<glm::vec3> images[2];
+    for (int run = 0; run < 2; run++)
+    {
+        render_settings settings;
+        settings.width = 64;
+        settings.height = 36;
+        settings.samples = 8;
+        settings.samplerType = rtweekend::sampler_type::sobol;
+        settings.threads = run == 0 ? 1 : 4;
+        settings.tileSize = run == 0 ? 32 : 8;
+        renderer tracer(settings);
+        tracer.setLights(&lights);
+        tracer.render(*world, random_scene_camera(64.f / 36), images[run]);
+    }
+    report("render independent of threads and tiles", images[0] == images[1]);
+}
+
+static double mean_luminance(const vector<glm::vec3>& image)
+{
+    double sum = 0;
+    for (const glm::vec3& c : image)
+        sum += (c.x + c.y + c.z) / 3;
+    return sum / image.size();
+}
+
+// Next-event estimation with MIS must converge to the same image as BSDF sampling alone, with an
+// emitter light_list does not sample (a quad) in the scene and whatever order the light list and
+// the accelerator are built in.
+static void test_mis_energy()
+{
+    double means[4];
+    const char* names[] = { "bsdf only", "lights first", "accelerator first", "soa accelerator first" };
+    for (int mode = 0; mode < 4; mode++)
+    {
+        hittable_list scene = random_scene();
+        scene.add(make_shared<sphere>(vec3(2, 0.6, 2), 0.3, make_shared<diffuse_light>(vec3(20, 15, 10))));
+        scene.add(make_shared<quad>(vec3(-1, 3, -1), vec3(2, 0, 0), vec3(0, 0, 2), make_shared<diffuse_light>(vec3(8, 8, 8))));
+        shared_ptr<hittable> world;
+        light_list lights;
+        if (mode == 1) {
+            lights = light_list(scene);
+            world = make_accelerator(scene, bvh_layout::bvh4);
+        }
+        else {
+            world = mode == 3 ? make_sphere_accelerator(scene, bvh_layout::bvh4) : make_accelerator(scene, bvh_layout::bvh4);
+            lights = light_list(scene);
+        }
+        render_settings settings;
+        settings.width = 64;
+        settings.height = 36;
+        settings.samples = 256;
+        settings.sampleLights = mode != 0;
+        settings.skyIntensity = 0.05f;
+        renderer tracer(settings);
+        tracer.setLights(&lights);
+        vector<glm::vec3> image;
+        tracer.render(*world, random_scene_camera(64.f / 36), image);
+        means[mode] = mean_luminance(image);
+    }
+    for (int mode = 1; mode < 4; mode++)
+    {
+        double error = std::fabs(means[mode] / means[0] - 1);
+        report(string("mis energy (") + names[mode] + ")", error < 0.02,
+            "mean " + to_string(means[mode]) + " vs " + to_string(means[0]) + " " + names[0]);
+    }
+}
+
+int main()
+{
+    test_philox_known_answers();
+    test_sampler_is_pure();
+    test_sampler_stratification();
+    test_accelerators_match_list();
+    test_custom_matches_builtin();
+    test_tiles_reported_once();
+    test_render_independent_of_threads();
+    test_mis_energy();
+    cout << (failures ? to_string(failures) + " failed" : string("all passed")) << endl;
+    return failures;
+}